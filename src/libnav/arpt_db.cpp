@@ -16,37 +16,218 @@
 
 namespace libnav
 {
+	inline bool is_apt_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	/*
+		Function: get_apt_words
+		Description:
+		Splits a line of apt.dat into at most n_max words without copying it. Words may
+		be separated by any number of spaces or tabs. The rest of the line isn't scanned,
+		so rows can be classified by their first word cheaply.
+		@param line: pointer to the first character of the line
+		@param len: length of the line
+		@param out: pointer to the output array. Must hold at least n_max items.
+		@param n_max: maximum number of words to split off
+		@return: number of words written to out
+	*/
+
+	inline size_t get_apt_words(const char* line, size_t len, strutils::str_view_t* out,
+		size_t n_max)
+	{
+		size_t n_out = 0;
+		size_t i = 0;
+		while (n_out < n_max)
+		{
+			while (i < len && is_apt_space(line[i]))
+			{
+				i++;
+			}
+			if (i == len)
+			{
+				break;
+			}
+			size_t j = i;
+			while (j < len && !is_apt_space(line[j]))
+			{
+				j++;
+			}
+			out[n_out] = {line + i, j - i};
+			n_out++;
+			i = j;
+		}
+		return n_out;
+	}
+
+	/*
+		Function: get_next_sect
+		Description:
+		Finds the end of the section of apt.dat that contains beg. A section ends at the 
+		terminating line or at an airport header that resets the state of the parser: 
+		the header must have an elevation and the airport before it must have an icao 
+		code. Thus sections can be parsed independently.
+		@param beg: pointer to the beginning of a line
+		@param end: pointer to the end of the file
+		@param is_sect_beg: true if a section starts at beg. Otherwise, the airport that
+		contains beg is skipped, since its icao code may be above beg.
+		@return: pointer to the first line of the next section or end
+	*/
+
+	inline const char* get_next_sect(const char* beg, const char* end, bool is_sect_beg)
+	{
+		bool has_arpt = is_sect_beg;  // The header of the current airport has been found
+		bool has_icao = false;
+		while (beg < end)
+		{
+			size_t line_len;
+			const char* next = strutils::next_line(beg, end, &line_len);
+			strutils::str_view_t s_split[N_MISC_DATA_ITEMS];
+			size_t n_words = get_apt_words(beg, line_len, s_split, 1);
+			int row_code = 0;
+			if (n_words)
+			{
+				row_code = strutils::view_to_int(s_split[0]);
+			}
+			// Only these rows are split into more words
+			if (row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT) || 
+				row_code == static_cast<int>(XPLMArptRowCode::MISC_DATA))
+			{
+				n_words = get_apt_words(beg, line_len, s_split, N_MISC_DATA_ITEMS);
+			}
+
+			if (row_code == static_cast<int>(XPLMArptRowCode::DB_EOF))
+			{
+				break;
+			}
+			else if (row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT))
+			{
+				if (has_arpt && has_icao && n_words >= 2)
+				{
+					break;
+				}
+				has_arpt = true;
+				has_icao = false;
+			}
+			else if (row_code == static_cast<int>(XPLMArptRowCode::MISC_DATA) && 
+				n_words >= N_MISC_DATA_ITEMS - 1 && s_split[1] == "icao_code")
+			{
+				has_icao = n_words == N_MISC_DATA_ITEMS;
+			}
+			beg = next;
+		}
+
+		return beg;
+	}
+
+	/*
+		Function: get_arpt_chunks
+		Description:
+		Splits the airport part of apt.dat into n_chunks parts of roughly equal size. 
+		Each part starts at the beginning of a section. See get_next_sect.
+		@param beg: pointer to the first line after the header of the file
+		@param end: pointer to the end of the file
+		@param n_chunks: number of chunks
+		@Return: vector of n_chunks+1 boundaries. Chunk i is [out[i], out[i+1]).
+	*/
+
+	inline std::vector<const char*> get_arpt_chunks(const char* beg, const char* end, 
+		size_t n_chunks)
+	{
+		std::vector<const char*> out = strutils::get_line_chunks(beg, end, n_chunks);
+		for (size_t i = 1; i < n_chunks; i++)
+		{
+			out[i] = get_next_sect(std::max(out[i], out[i-1]), end, false);
+		}
+
+		return out;
+	}
+
+	/*
+		Function: get_sect_hash
+		Description:
+		Hashes the text of a section of apt.dat 8 bytes at a time.
+		@param data: pointer to the beginning of the section
+		@param len: length of the section
+		@param flush: false if the section is the last one and there is no terminating
+		line after it. The last airport of such a section isn't added to the data base.
+		@return: hash of the section
+	*/
+
+	inline uint64_t get_sect_hash(const char* data, size_t len, bool flush)
+	{
+		const uint64_t k_mul = 0x9E3779B97F4A7C15;
+		uint64_t h = (uint64_t(len) * k_mul) ^ uint64_t(flush);
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+		{
+			uint64_t w;
+			memcpy(&w, data + i, sizeof(uint64_t));
+			h = (h ^ w) * k_mul;
+			h ^= h >> 29;
+		}
+		uint64_t w = 0;
+		memcpy(&w, data + i, len - i);
+		h = (h ^ w) * k_mul;
+
+		h ^= h >> 32;
+		h *= 0xD6E8FEB86659FD93;
+		h ^= h >> 32;
+		return h;
+	}
+
+
 	// Public member functions
 
 	ArptDB::ArptDB(std::string sim_arpt_path, std::string custom_arpt_path,
-		std::string custom_rnw_path, double min_rwy_l_m)
+		std::string custom_rnw_path, double min_rwy_l_m, size_t n_load_thr)
 	{
 		err_code = DbErr::ERR_NONE;
 
 		db_version = 0;
 		min_rwy_length_m = min_rwy_l_m;
+		n_load_threads = n_load_thr;
+		if(n_load_threads == 0)
+		{
+			n_load_threads = std::max(size_t(std::thread::hardware_concurrency()), 
+				size_t(1));
+		}
 
 		sim_arpt_db_path = sim_arpt_path;
 		custom_arpt_db_path = custom_arpt_path;
 		custom_rnw_db_path = custom_rnw_path;
+		// If apt.dat is missing, the custom data bases are used as they are
+		has_src_stamp = get_file_stamp(sim_arpt_db_path, &src_stamp);
 
-		
-		if (!does_db_exist(custom_arpt_db_path, custom_arpt_db_sign) || 
-			!does_db_exist(custom_rnw_db_path, custom_rnw_db_sign))
+
+		bool arpt_db_exists = does_db_exist(custom_arpt_db_path, custom_arpt_db_sign, 
+			sizeof(arpt_cache_arpt_t));
+		bool rnw_db_exists = does_db_exist(custom_rnw_db_path, custom_rnw_db_sign, 
+			sizeof(arpt_cache_grp_t));
+		if (!arpt_db_exists || !rnw_db_exists)
 		{
 			if(does_file_exist(sim_arpt_db_path))
 			{
-				write_arpt_db.store(true, std::memory_order_seq_cst);
-				sim_db_loaded = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->load_from_sim_db(); }, this);
-				if (!does_db_exist(custom_arpt_db_path, custom_arpt_db_sign))
+				if (!arpt_db_exists)
 				{
 					apt_db_created = true;
-					arpt_db_task = std::async(std::launch::async, [](ArptDB* ptr) {ptr->write_to_arpt_db(); }, this);
+					arpt_db_task = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->write_to_arpt_db(); }, this);
 				}
-				if (!does_db_exist(custom_rnw_db_path, custom_rnw_db_sign))
+				if (!rnw_db_exists)
 				{
 					rnw_db_created = true;
-					rnw_db_task = std::async(std::launch::async, [](ArptDB* ptr) {ptr->write_to_rnw_db(); }, this);
+					rnw_db_task = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->write_to_rnw_db(); }, this);
+				}
+				// The loader only fills the queues of the data bases that are being created.
+				// If both of them are out of date, they may be updated instead.
+				if (!arpt_db_exists && !rnw_db_exists)
+				{
+					sim_db_loaded = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->update_from_sim_db(); }, this);
+				}
+				else
+				{
+					sim_db_loaded = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->load_from_sim_db(); }, this);
 				}
 			}
 			else
@@ -56,8 +237,8 @@ namespace libnav
 		}
 		else
 		{
-			arpt_db_task = std::async(std::launch::async, [](ArptDB* ptr) {ptr->load_from_custom_arpt(); }, this);
-			rnw_db_task = std::async(std::launch::async, [](ArptDB* ptr) {ptr->load_from_custom_rnw(); }, this);
+			arpt_db_task = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->load_from_custom_arpt(); }, this);
+			rnw_db_task = std::async(std::launch::async, [](ArptDB* ptr) -> int { return ptr->load_from_custom_rnw(); }, this);
 		}
 		
 	}
@@ -66,11 +247,18 @@ namespace libnav
 	{
 		if(err_code == DbErr::ERR_NONE)
 		{
-			// Wait until all of the threads finish
-			arpt_db_task.get();
-			rnw_db_task.get();
+			// Wait until all of the threads finish. Only one of the custom data bases
+			// may need to be created.
+			int arpt_res = 1;
+			int rnw_res = 1;
+			if (arpt_db_task.valid())
+				arpt_res = arpt_db_task.get();
+			if (rnw_db_task.valid())
+				rnw_res = rnw_db_task.get();
 			if (apt_db_created || rnw_db_created)
 			{
+				// Failing to write a custom data base isn't an error. It will be 
+				// created next time.
 				if(bool(sim_db_loaded.get()))
 				{
 					err_code = DbErr::SUCCESS;
@@ -80,10 +268,14 @@ namespace libnav
 					err_code = DbErr::DATA_BASE_ERROR;
 				}
 			}
-			else
+			else if (arpt_res && rnw_res)
 			{
 				err_code = DbErr::SUCCESS;
 			}
+			else
+			{
+				err_code = DbErr::DATA_BASE_ERROR;
+			}
 		}
 		
 		return err_code;
@@ -108,6 +300,9 @@ namespace libnav
 		Function that parses airport data from x-plane's apt.dat and adds all of the neccessary data to 
 		arpt_db and rnw_db. The function also creates 2 .dat files for caching all of the neccessary data. 
 		All airports with maximum runway length below MIN_RWY_LENGTH_M are rejected.
+		The file is memory-mapped and scanned in place. Only the row code is read from
+		rows other than 1, 100 and 1302. The file is split into chunks at airport 
+		headers, which are parsed by n_load_threads threads.
 		Param:
 		-----
 		Return:
@@ -116,309 +311,275 @@ namespace libnav
 
 	int ArptDB::load_from_sim_db()
 	{
-		std::ifstream file(sim_arpt_db_path, std::ifstream::in);
-		if (file.is_open())
-		{
-			std::string line;
-			int i = 0;
-			int limit = N_ARPT_LINES_IGNORE;
-			airport_t tmp_arpt = { "", {{0, 0}, 0, 0, 0} };
-			rnw_data_t tmp_rnw = { "", {} };
-			double max_rnw_length_m = 0;
-
-			while (getline(file, line))
-			{
-				if (i >= limit && line != "")
-				{
-					int row_code;
-					std::string junk;
-					std::stringstream s(line);
-					s >> row_code;
-
-					if (tmp_arpt.icao != "" && tmp_rnw.icao != "" && 
-						(row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT)
-						 || row_code == static_cast<int>(XPLMArptRowCode::DB_EOF)))
-					{
-						// Offload airport data
-						double threshold = min_rwy_length_m;
-
-						if (max_rnw_length_m >= threshold && tmp_arpt.data.transition_alt_ft + 
-							tmp_arpt.data.transition_level > 0)
-						{
-							std::unordered_map<std::string, runway_entry_t> apt_runways;
-							size_t n_runways = tmp_rnw.runways.size();
-
-							for (size_t i = 0; i < n_runways; i++)
-							{
-								runway_t rnw = tmp_rnw.runways.at(i);
-								std::pair<std::string, runway_entry_t> tmp = std::make_pair(rnw.id, rnw.data);
-								apt_runways.insert(tmp);
-								tmp_arpt.data.pos.lat_rad += rnw.data.start.lat_rad;
-								tmp_arpt.data.pos.lon_rad += rnw.data.start.lon_rad;
-							}
-
-							tmp_arpt.data.pos.lat_rad /= double(n_runways);
-							tmp_arpt.data.pos.lon_rad /= double(n_runways);
-
-							// Update queues
-
-							add_to_arpt_queue(tmp_arpt);
-							add_to_rnw_queue(tmp_rnw);
-
-							// Update internal data
-
-							str_arpt_data_t apt = std::make_pair(tmp_arpt.icao, 
-								tmp_arpt.data);
-							str_rnw_t rnw_pair = std::make_pair(tmp_arpt.icao, 
-								apt_runways);
-							arpt_db.insert(apt);
-							rnw_db.insert(rnw_pair);
-						}
-
-						tmp_arpt.icao = "";
-						tmp_rnw.icao = "";
-						tmp_arpt.data.pos = { 0, 0 };
-						tmp_arpt.data.transition_alt_ft = 0;
-						tmp_arpt.data.transition_level = 0;
-						tmp_rnw.runways.clear();
-						max_rnw_length_m = 0;
-					}
+		int ret = parse_sim_db(nullptr);
+		close_queues();
+		return ret;
+	}
 
-					// Parse data
+	/*
+		Function: update_from_sim_db
+		Description:
+		Updates the custom data bases after apt.dat has changed. apt.dat is split into
+		sections, which are hashed. Sections that are found in the custom airport data 
+		base are copied from the old custom data bases, the rest are parsed. If the old 
+		data bases can't be used, apt.dat is parsed from scratch.
+		Param:
+		-----
+		Return:
+		Returns 1 if x-plane's airport data base has been loaded successfully. Otherwise, returns 0.
+	*/
 
-					if (row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT))
-					{
-						s >> tmp_arpt.data.elevation_ft;
-					}
-					else if (row_code == static_cast<int>(XPLMArptRowCode::MISC_DATA))
-					{
-						std::string var_name;
-						s >> var_name;
-						if (var_name == "icao_code")
-						{
-							std::string icao_code;
-							s >> icao_code;
-							tmp_arpt.icao = icao_code;
-							tmp_rnw.icao = icao_code;
-						}
-						else if (var_name == "transition_alt")
-						{
-							s >> tmp_arpt.data.transition_alt_ft;
-						}
-						else if (var_name == "transition_level")
-						{
-							s >> tmp_arpt.data.transition_level;
-						}
-					}
-					else if (row_code == static_cast<int>(XPLMArptRowCode::LAND_RUNWAY)
-						 && tmp_arpt.icao != "")
-					{
-						double tmp = parse_runway(line, &tmp_rnw.runways);
-						if (tmp > max_rnw_length_m)
-						{
-							max_rnw_length_m = tmp;
-						}
-					}
-					else if (row_code == static_cast<int>(XPLMArptRowCode::DB_EOF))
-					{
-						break;
-					}
-				}
-				else
-				{
-					int tmp = get_db_version(line);
-					if(tmp)
-						db_version = tmp;
-				}
-				i++;
-			}
-			file.close();
-			write_arpt_db.store(false, std::memory_order_seq_cst);
-			return 1;
-		}
-		file.close();
-		return 0;
+	int ArptDB::update_from_sim_db()
+	{
+		// The writers truncate the custom data bases once the queues have been closed,
+		// so the old ones must be unmapped by then. On Windows, a file can't be opened
+		// for writing while it's mapped.
+		int ret = parse_with_old_dbs();
+		close_queues();
+		return ret;
 	}
 
 	/*
 		Function: write_to_arpt_db
 		Description:
-		Creates and populates a .dat file with all of the useful information about each airport.
-		This includes icao code, latitude, longitude, elevation AMSL in feet, transition altitude 
-		and transition level.
+		Creates a binary file with all of the useful information about each airport.
+		This includes icao code, position, elevation AMSL in feet, transition altitude 
+		and transition level. The file is written once the queue has been closed, along
+		with the sections of apt.dat, which are used by update_from_sim_db.
 		Param:
 		-----
 		Return:
-		------
+		Returns 1 if the file has been written successfully. Otherwise, returns 0.
 	*/
 
-	void ArptDB::write_to_arpt_db()
+	int ArptDB::write_to_arpt_db()
 	{
-		std::ofstream out(custom_arpt_db_path, std::ofstream::out);
-		out << custom_arpt_db_sign << " " << std::to_string(DB_VERSION) << "\n";
-		while (arpt_queue.size() || write_arpt_db.load(std::memory_order_seq_cst))
+		std::vector<airport_t> batch;
+		std::vector<arpt_cache_arpt_t> arpts;
+		std::string str_tbl;
+		while (get_arpt_batch(&batch))
 		{
-			if (arpt_queue.size())
+			for (size_t i = 0; i < batch.size(); i++)
 			{
-				std::lock_guard<std::mutex> lock(arpt_queue_mutex);
-				uint8_t precision = N_DOUBLE_OUT_PRECISION;
-				airport_t data = arpt_queue[0];
-				arpt_queue.erase(arpt_queue.begin());
+				airport_data_t& data = batch[i].data;
+				arpt_cache_arpt_t tmp;
+				memset(&tmp, 0, sizeof(arpt_cache_arpt_t));
+				tmp.icao = add_cache_str(str_tbl, batch[i].icao);
+				tmp.elevation_ft = data.elevation_ft;
+				tmp.transition_alt_ft = data.transition_alt_ft;
+				tmp.transition_level = data.transition_level;
+				tmp.lat_rad = data.pos.lat_rad;
+				tmp.lon_rad = data.pos.lon_rad;
+				geo::nvec nv = data.get_nvec();
+				tmp.nv_x = nv.x;
+				tmp.nv_y = nv.y;
+				tmp.nv_z = nv.z;
+				arpts.push_back(tmp);
+			}
+			batch.clear();
+		}
+
+		if (str_tbl.size() > UINT32_MAX)
+		{
+			return 0;
+		}
 
-				std::string arpt_lat = strutils::double_to_str(data.data.pos.lat_rad 
-					* geo::RAD_TO_DEG, precision);
-				std::string arpt_lon = strutils::double_to_str(data.data.pos.lon_rad 
-					* geo::RAD_TO_DEG, precision);
-				std::string arpt_icao_pos = data.icao + " " + arpt_lat + " " + arpt_lon;
+		arpt_cache_hdr_t hdr = get_cache_hdr(custom_arpt_db_sign);
+		hdr.n_arpts = arpts.size();
+		hdr.n_sects = arpt_sects.size();
+		hdr.str_sz = str_tbl.size();
 
-				out << arpt_icao_pos << " " << data.data.elevation_ft << " " << data.data.transition_alt_ft << " " << data.data.transition_level << "\n";
-			}
+		std::ofstream out(custom_arpt_db_path, std::ofstream::binary | std::ofstream::trunc);
+		if (!out.is_open())
+		{
+			return 0;
 		}
+		out.write(reinterpret_cast<const char*>(&hdr), sizeof(arpt_cache_hdr_t));
+		out.write(reinterpret_cast<const char*>(arpts.data()), 
+			std::streamsize(arpts.size() * sizeof(arpt_cache_arpt_t)));
+		out.write(reinterpret_cast<const char*>(arpt_sects.data()), 
+			std::streamsize(arpt_sects.size() * sizeof(arpt_cache_sect_t)));
+		out.write(str_tbl.data(), std::streamsize(str_tbl.size()));
 		out.close();
+
+		return int(!out.fail());
 	}
 
 	/*
 		Function: write_to_rnw_db
 		Description:
-		Creates and populates a .dat file with all of the useful information about each airport's runway.
-		This includes id of the runway(e.g. 08L), latitude and longitude for strat poind and end point and
-		the length of the displaced threshold in meters.
+		Creates a binary file with all of the useful information about each airport's runway.
+		This includes id of the runway(e.g. 08L), positions of the start point and the end point
+		and the length of the displaced threshold in meters. The file is written once the queue 
+		has been closed.
 		Param:
 		-----
 		Return:
-		------
+		Returns 1 if the file has been written successfully. Otherwise, returns 0.
 	*/
 
-	void ArptDB::write_to_rnw_db()
+	int ArptDB::write_to_rnw_db()
 	{
-		std::ofstream out(custom_rnw_db_path, std::ofstream::out);
-		out << custom_rnw_db_sign << " " << std::to_string(DB_VERSION) << "\n";
-		while (rnw_queue.size() || write_arpt_db.load(std::memory_order_seq_cst))
+		std::vector<rnw_data_t> batch;
+		std::vector<arpt_cache_grp_t> grps;
+		std::vector<arpt_cache_rnw_t> rnws;
+		std::string str_tbl;
+		while (get_rnw_batch(&batch))
 		{
-			if (rnw_queue.size())
+			for (size_t i = 0; i < batch.size(); i++)
 			{
-				std::lock_guard<std::mutex> lock(rnw_queue_mutex);
-				uint8_t precision = N_DOUBLE_OUT_PRECISION;
-				rnw_data_t data = rnw_queue[0];
-				rnw_queue.erase(rnw_queue.begin());
-				for (size_t i = 0; i < data.runways.size(); i++)
-				{
-					std::string rnw_start_lat = strutils::double_to_str(
-						data.runways[i].data.start.lat_rad * geo::RAD_TO_DEG, precision);
-
-					std::string rnw_start_lon = strutils::double_to_str(
-						data.runways[i].data.start.lon_rad * geo::RAD_TO_DEG, precision);
-
-					std::string rnw_end_lat = strutils::double_to_str(
-						data.runways[i].data.end.lat_rad * geo::RAD_TO_DEG, precision);
-
-					std::string rnw_end_lon = strutils::double_to_str(
-						data.runways[i].data.end.lon_rad * geo::RAD_TO_DEG, precision);
+				arpt_cache_grp_t grp;
+				memset(&grp, 0, sizeof(arpt_cache_grp_t));
+				grp.icao = add_cache_str(str_tbl, batch[i].icao);
+				grp.n_rnws = uint32_t(batch[i].runways.size());
+				grps.push_back(grp);
 
+				for (size_t j = 0; j < batch[i].runways.size(); j++)
+				{
+					runway_entry_t& data = batch[i].runways[j].data;
+					arpt_cache_rnw_t tmp;
+					memset(&tmp, 0, sizeof(arpt_cache_rnw_t));
+					tmp.id = add_cache_str(str_tbl, batch[i].runways[j].id);
+					tmp.displ_threshold_m = data.displ_threshold_m;
+					tmp.start_lat_rad = data.start.lat_rad;
+					tmp.start_lon_rad = data.start.lon_rad;
+					tmp.end_lat_rad = data.end.lat_rad;
+					tmp.end_lon_rad = data.end.lon_rad;
+					geo::nvec start_nv = data.get_start_nvec();
+					geo::nvec end_nv = data.get_end_nvec();
+					tmp.start_nv_x = start_nv.x;
+					tmp.start_nv_y = start_nv.y;
+					tmp.start_nv_z = start_nv.z;
+					tmp.end_nv_x = end_nv.x;
+					tmp.end_nv_y = end_nv.y;
+					tmp.end_nv_z = end_nv.z;
+					rnws.push_back(tmp);
+				}
+			}
+			batch.clear();
+		}
 
-					std::string rnw_start = rnw_start_lat + " " + rnw_start_lon;
-					std::string rnw_end = rnw_end_lat + " " + rnw_end_lon;
+		if (str_tbl.size() > UINT32_MAX)
+		{
+			return 0;
+		}
 
-					std::string rnw_icao_pos = data.icao + " " + data.runways[i].id + " " + rnw_start + " " + rnw_end;
+		arpt_cache_hdr_t hdr = get_cache_hdr(custom_rnw_db_sign);
+		hdr.n_arpts = grps.size();
+		hdr.n_rnws = rnws.size();
+		hdr.str_sz = str_tbl.size();
 
-					out << rnw_icao_pos << " " << data.runways[i].data.displ_threshold_m << "\n";
-				}
-			}
+		std::ofstream out(custom_rnw_db_path, std::ofstream::binary | std::ofstream::trunc);
+		if (!out.is_open())
+		{
+			return 0;
 		}
+		out.write(reinterpret_cast<const char*>(&hdr), sizeof(arpt_cache_hdr_t));
+		out.write(reinterpret_cast<const char*>(grps.data()), 
+			std::streamsize(grps.size() * sizeof(arpt_cache_grp_t)));
+		out.write(reinterpret_cast<const char*>(rnws.data()), 
+			std::streamsize(rnws.size() * sizeof(arpt_cache_rnw_t)));
+		out.write(str_tbl.data(), std::streamsize(str_tbl.size()));
 		out.close();
+
+		return int(!out.fail());
 	}
 
 	/*
 		Function: load_from_custom_arpt
 		Description:
-		Loads data from .dat file created by write_to_arpt_db into arpt_db.
+		Loads data from the file created by write_to_arpt_db into arpt_db. The file is 
+		mapped into memory and the records are copied directly, no text is parsed.
 		Param:
 		-----
 		Return:
-		------
+		Returns 1 if the data base has been loaded successfully. Otherwise, returns 0.
 	*/
 
-	void ArptDB::load_from_custom_arpt()
+	int ArptDB::load_from_custom_arpt()
 	{
-		std::ifstream file(custom_arpt_db_path, std::ifstream::in);
-		if (file.is_open())
+		MappedFile file(custom_arpt_db_path);
+		arpt_cache_hdr_t hdr;
+		if (!read_cache_hdr(file, custom_arpt_db_sign, sizeof(arpt_cache_arpt_t), true, 
+			&hdr) || hdr.n_rnws != 0)
 		{
-			std::string line;
-			while (getline(file, line))
+			return 0;
+		}
+
+		const char* curr = file.data() + sizeof(arpt_cache_hdr_t);
+		const char* str_tbl = file.data() + (file.size() - hdr.str_sz);
+
+		arpt_db.reserve(size_t(hdr.n_arpts));
+		for (uint64_t i = 0; i < hdr.n_arpts; i++)
+		{
+			airport_t tmp;
+			if (!read_cache_arpt(curr, str_tbl, hdr.str_sz, &tmp))
 			{
-				if(line.length() == 0 || line[0] == DEFAULT_COMMENT_CHAR)
-				{
-					continue;
-				}
-				if (line != custom_arpt_db_sign)
-				{
-					std::string icao;
-					airport_data_t tmp;
-					std::stringstream s(line);
-					s >> icao >> tmp.pos.lat_rad >> tmp.pos.lon_rad >> tmp.elevation_ft >> tmp.transition_alt_ft >> tmp.transition_level;
-					tmp.pos.lat_rad *= geo::DEG_TO_RAD;
-					tmp.pos.lon_rad *= geo::DEG_TO_RAD;
-					std::pair<std::string, airport_data_t> tmp_pair = std::make_pair(icao, tmp);
-					arpt_db.insert(tmp_pair);
-				}
+				return 0;
 			}
-			file.close();
+			curr += sizeof(arpt_cache_arpt_t);
+			arpt_db.insert(std::make_pair(tmp.icao, tmp.data));
 		}
-		file.close();
+
+		return 1;
 	}
 
 	/*
 		Function: load_from_custom_rnw
 		Description:
-		Loads data from .dat file created by write_to_rnw_db into rnw_db.
+		Loads data from the file created by write_to_rnw_db into rnw_db. The file is 
+		mapped into memory and the records are copied directly, no text is parsed.
 		Param:
-		Param pam pam
+		-----
 		Return:
-		------
+		Returns 1 if the data base has been loaded successfully. Otherwise, returns 0.
 	*/
 
-	void ArptDB::load_from_custom_rnw()
+	int ArptDB::load_from_custom_rnw()
 	{
-		std::ifstream file(custom_rnw_db_path, std::ifstream::in);
-		if (file.is_open())
+		MappedFile file(custom_rnw_db_path);
+		arpt_cache_hdr_t hdr;
+		if (!read_cache_hdr(file, custom_rnw_db_sign, sizeof(arpt_cache_grp_t), true, 
+			&hdr) || hdr.n_sects != 0)
 		{
-			std::string line;
-			std::string curr_icao = "";
-			std::unordered_map<std::string, runway_entry_t> runways = {};
-			while (getline(file, line))
+			return 0;
+		}
+
+		const char* grp_ptr = file.data() + sizeof(arpt_cache_hdr_t);
+		const char* rnw_ptr = grp_ptr + hdr.n_arpts * sizeof(arpt_cache_grp_t);
+		const char* str_tbl = file.data() + (file.size() - hdr.str_sz);
+
+		rnw_db.reserve(size_t(hdr.n_arpts));
+		uint64_t n_rnws_left = hdr.n_rnws;
+		for (uint64_t i = 0; i < hdr.n_arpts; i++)
+		{
+			arpt_cache_grp_t grp;
+			memcpy(&grp, grp_ptr, sizeof(arpt_cache_grp_t));
+			grp_ptr += sizeof(arpt_cache_grp_t);
+
+			std::string icao;
+			if (grp.n_rnws > n_rnws_left || 
+				!get_cache_str(str_tbl, hdr.str_sz, grp.icao, &icao))
+			{
+				return 0;
+			}
+			n_rnws_left -= grp.n_rnws;
+
+			std::unordered_map<std::string, runway_entry_t> runways;
+			for (uint32_t j = 0; j < grp.n_rnws; j++)
 			{
-				if(line.length() == 0 || line[0] == DEFAULT_COMMENT_CHAR)
+				runway_t tmp;
+				if (!read_cache_rnw(rnw_ptr, str_tbl, hdr.str_sz, &tmp))
 				{
-					continue;
-				}
-				if (line != custom_rnw_db_sign)
-				{
-					std::string icao, rnw_id;
-					runway_entry_t tmp;
-					std::stringstream s(line);
-					s >> icao;
-					if (icao != curr_icao)
-					{
-						if (curr_icao != "")
-						{
-							std::pair<std::string, std::unordered_map<std::string, runway_entry_t>> icao_runways = std::make_pair(curr_icao, runways);
-							rnw_db.insert(icao_runways);
-						}
-						curr_icao = icao;
-						runways.clear();
-					}
-					s >> rnw_id >> tmp.start.lat_rad >> tmp.start.lon_rad >> tmp.end.lat_rad >> tmp.end.lon_rad >> tmp.displ_threshold_m;
-					tmp.start.lat_rad *= geo::DEG_TO_RAD;
-					tmp.start.lon_rad *= geo::DEG_TO_RAD;
-					tmp.end.lat_rad *= geo::DEG_TO_RAD;
-					tmp.end.lon_rad *= geo::DEG_TO_RAD;
-					std::pair<std::string, runway_entry_t> str_rnw_entry = std::make_pair(rnw_id, tmp);
-					runways.insert(str_rnw_entry);
+					return 0;
 				}
+				rnw_ptr += sizeof(arpt_cache_rnw_t);
+				runways.insert(std::make_pair(tmp.id, tmp.data));
 			}
-			file.close();
+			rnw_db.insert(std::make_pair(icao, std::move(runways)));
 		}
-		file.close();
+
+		return 1;
 	}
 
 	// Normal user interface functions:
@@ -433,7 +594,7 @@ namespace libnav
 		true if if there's an airport in the data base with such ICAO code. Otherwise, returns false.
 	*/
 
-	bool ArptDB::is_airport(std::string icao_code)
+	bool ArptDB::is_airport(const std::string& icao_code)
 	{
 		std::lock_guard<std::mutex> lock(arpt_db_mutex);
 		return arpt_db.find(icao_code) != arpt_db.end();
@@ -450,12 +611,13 @@ namespace libnav
 		Returns 1 if any data has been written to out. Otherwise, returns 0.
 	*/
 
-	bool ArptDB::get_airport_data(std::string icao_code, airport_data_t* out)
+	bool ArptDB::get_airport_data(const std::string& icao_code, airport_data_t* out)
 	{
-		if (is_airport(icao_code))
+		std::lock_guard<std::mutex> lock(arpt_db_mutex);
+		auto it = arpt_db.find(icao_code);
+		if (it != arpt_db.end())
 		{
-			std::lock_guard<std::mutex> lock(arpt_db_mutex);
-			*out = arpt_db.at(icao_code);
+			*out = it->second;
 			return 1;
 		}
 		return 0;
@@ -472,14 +634,18 @@ namespace libnav
 		Returns number of runways of an airport if any data has been written to out. Otherwise, returns 0.
 	*/
 
-	int ArptDB::get_apt_rwys(std::string icao_code, runway_data* out)
+	int ArptDB::get_apt_rwys(const std::string& icao_code, runway_data* out)
 	{
 		if (is_airport(icao_code))
 		{
 			std::lock_guard<std::mutex> lock(rnw_db_mutex);
 			int n_runways = 0;
-			runway_data tmp = rnw_db.at(icao_code);
-			for (auto& it : tmp)
+			auto apt_it = rnw_db.find(icao_code);
+			if (apt_it == rnw_db.end())
+			{
+				return 0;
+			}
+			for (auto& it : apt_it->second)
 			{
 				out->insert(it);
 				n_runways++;
@@ -501,44 +667,103 @@ namespace libnav
 		Returns 1 if runway data was found and written to out. Otherwise, returns 0.
 	*/
 
-	int ArptDB::get_rnw_data(std::string apt_icao, std::string rnw_id, runway_entry_t* out)
+	int ArptDB::get_rnw_data(const std::string& apt_icao, const std::string& rnw_id, 
+		runway_entry_t* out)
 	{
 		if (is_airport(apt_icao))
 		{
 			std::lock_guard<std::mutex> lock(rnw_db_mutex);
-			runway_data tmp = rnw_db.at(apt_icao);
+			auto apt_it = rnw_db.find(apt_icao);
+			if (apt_it == rnw_db.end())
+			{
+				return 0;
+			}
 
-			if (tmp.find(rnw_id) != tmp.end())
+			auto rnw_it = apt_it->second.find(rnw_id);
+			if (rnw_it != apt_it->second.end())
 			{
-				*out = tmp.at(rnw_id);
+				*out = rnw_it->second;
 				return 1;
 			}
 		}
 		return 0;
 	}
 
+	const airport_data_t* ArptDB::find_airport(const std::string& icao_code)
+	{
+		auto it = arpt_db.find(icao_code);
+		if (it != arpt_db.end())
+		{
+			return &it->second;
+		}
+		return nullptr;
+	}
+
+	const runway_data* ArptDB::find_apt_rwys(const std::string& icao_code)
+	{
+		auto it = rnw_db.find(icao_code);
+		if (it != rnw_db.end())
+		{
+			return &it->second;
+		}
+		return nullptr;
+	}
+
 	// Private member functions:
 
-	bool ArptDB::does_db_exist(std::string path, std::string sign)
+	bool ArptDB::does_db_exist(std::string path, std::string sign, size_t arpt_rec_sz)
+	{
+		MappedFile file(path);
+		arpt_cache_hdr_t hdr;
+		return read_cache_hdr(file, sign, arpt_rec_sz, true, &hdr);
+	}
+
+	arpt_cache_hdr_t ArptDB::get_cache_hdr(std::string& sign)
 	{
-		std::ifstream file(path, std::ifstream::in);
-		if (file.is_open())
+		arpt_cache_hdr_t hdr;
+		memset(&hdr, 0, sizeof(arpt_cache_hdr_t));
+		memcpy(hdr.sign, sign.c_str(), std::min(sign.size(), ARPT_CACHE_SIGN_SZ - 1));
+		hdr.byte_order = ARPT_CACHE_BYTE_ORDER;
+		hdr.db_version = DB_VERSION;
+		hdr.src_size = src_stamp.size;
+		hdr.src_mtime = src_stamp.mtime;
+		hdr.min_rwy_length_m = min_rwy_length_m;
+		return hdr;
+	}
+
+	bool ArptDB::read_cache_hdr(MappedFile& file, std::string& sign, size_t arpt_rec_sz, 
+		bool check_src, arpt_cache_hdr_t* out)
+	{
+		if (!file.is_open() || file.size() < sizeof(arpt_cache_hdr_t))
 		{
-			std::string line, tmp;
-			double ver = 0;
-			getline(file, line);
-			std::stringstream s(line);
-			
-			s >> tmp >> ver;
+			return false;
+		}
+		memcpy(out, file.data(), sizeof(arpt_cache_hdr_t));
 
-			if (tmp == sign && ver == DB_VERSION)
-			{
-				file.close();
-				return true;
-			}
+		arpt_cache_hdr_t ref = get_cache_hdr(sign);
+		if (memcmp(out->sign, ref.sign, ARPT_CACHE_SIGN_SZ) || 
+			out->byte_order != ref.byte_order || out->db_version != ref.db_version || 
+			out->min_rwy_length_m != ref.min_rwy_length_m)
+		{
+			return false;
 		}
-		file.close();
-		return false;
+
+		// Check the counts one by one so that the size calculation can't overflow.
+		uint64_t sz_left = file.size() - sizeof(arpt_cache_hdr_t);
+		if (out->n_arpts > sz_left / arpt_rec_sz)
+			return false;
+		sz_left -= out->n_arpts * arpt_rec_sz;
+		if (out->n_sects > sz_left / sizeof(arpt_cache_sect_t))
+			return false;
+		sz_left -= out->n_sects * sizeof(arpt_cache_sect_t);
+		if (out->n_rnws > sz_left / sizeof(arpt_cache_rnw_t))
+			return false;
+		sz_left -= out->n_rnws * sizeof(arpt_cache_rnw_t);
+		if (out->str_sz != sz_left)
+			return false;
+
+		return !check_src || !has_src_stamp || (out->src_size == ref.src_size && 
+			out->src_mtime == ref.src_mtime);
 	}
 
 	int ArptDB::get_db_version(std::string& line)
@@ -554,25 +779,27 @@ namespace libnav
 		return 0;
 	}
 
-	double ArptDB::parse_runway(std::string line, std::vector<runway_t>* rnw)
+	double ArptDB::parse_runway(const char* line, size_t len, std::vector<runway_t>* rnw)
 	{
-		std::stringstream s(line);
-		int limit_1 = N_RNW_ITEMS_IGNORE_BEGINNING;
+		strutils::str_view_t s_split[N_RNW_ITEMS];
+		if (get_apt_words(line, len, s_split, N_RNW_ITEMS) != N_RNW_ITEMS)
+		{
+			return 0;
+		}
 
-		int limit_2 = N_RNW_ITEMS_IGNORE_END;
-		std::string junk;
+		size_t idx_1 = N_RNW_ITEMS_IGNORE_BEGINNING;
+		size_t idx_2 = idx_1 + N_RNW_END_ITEMS + N_RNW_ITEMS_IGNORE_END;
 		runway_t rnw_1;
 		runway_t rnw_2;
-		for (int i = 0; i < limit_1; i++)
-		{
-			s >> junk;
-		}
-		s >> rnw_1.id >> rnw_1.data.start.lat_rad >> rnw_1.data.start.lon_rad >> rnw_1.data.displ_threshold_m;
-		for (int i = 0; i < limit_2; i++)
-		{
-			s >> junk;
-		}
-		s >> rnw_2.id >> rnw_1.data.end.lat_rad >> rnw_1.data.end.lon_rad >> rnw_2.data.displ_threshold_m;
+		rnw_1.id = s_split[idx_1].to_str();
+		rnw_1.data.start.lat_rad = strutils::view_to_double(s_split[idx_1 + 1]);
+		rnw_1.data.start.lon_rad = strutils::view_to_double(s_split[idx_1 + 2]);
+		// Displaced thresholds are given with 2 decimals
+		rnw_1.data.displ_threshold_m = int(strutils::view_to_double(s_split[idx_1 + 3]));
+		rnw_2.id = s_split[idx_2].to_str();
+		rnw_1.data.end.lat_rad = strutils::view_to_double(s_split[idx_2 + 1]);
+		rnw_1.data.end.lon_rad = strutils::view_to_double(s_split[idx_2 + 2]);
+		rnw_2.data.displ_threshold_m = int(strutils::view_to_double(s_split[idx_2 + 3]));
 		
 		rnw_1.data.start.lat_rad *= geo::DEG_TO_RAD;
 		rnw_1.data.start.lon_rad *= geo::DEG_TO_RAD;
@@ -583,6 +810,8 @@ namespace libnav
 		rnw_2.data.start.lon_rad = rnw_1.data.end.lon_rad;
 		rnw_2.data.end.lat_rad = rnw_1.data.start.lat_rad;
 		rnw_2.data.end.lon_rad = rnw_1.data.start.lon_rad;
+		rnw_1.data.store_nvecs();
+		rnw_2.data.store_nvecs();
 
 		rnw_1.id = strutils::normalize_rnw_id(rnw_1.id);
 		rnw_2.id = strutils::normalize_rnw_id(rnw_2.id);
@@ -593,15 +822,563 @@ namespace libnav
 		return rnw_1.data.get_impl_length_m();
 	}
 
-	void ArptDB::add_to_arpt_queue(airport_t arpt)
+	int ArptDB::parse_with_old_dbs()
+	{
+		MappedFile arpt_file(custom_arpt_db_path);
+		MappedFile rnw_file(custom_rnw_db_path);
+		arpt_cache_hdr_t arpt_hdr;
+		arpt_cache_hdr_t rnw_hdr;
+		if (!read_cache_hdr(arpt_file, custom_arpt_db_sign, sizeof(arpt_cache_arpt_t), 
+			false, &arpt_hdr) || 
+			!read_cache_hdr(rnw_file, custom_rnw_db_sign, sizeof(arpt_cache_grp_t), 
+			false, &rnw_hdr) || 
+			arpt_hdr.n_rnws != 0 || rnw_hdr.n_sects != 0 || 
+			arpt_hdr.n_arpts != rnw_hdr.n_arpts || arpt_hdr.src_size != rnw_hdr.src_size || 
+			arpt_hdr.src_mtime != rnw_hdr.src_mtime)
+		{
+			return parse_sim_db(nullptr);
+		}
+
+		arpt_cache_view_t old;
+		old.n_arpts = arpt_hdr.n_arpts;
+		old.n_rnws = rnw_hdr.n_rnws;
+		old.arpts = arpt_file.data() + sizeof(arpt_cache_hdr_t);
+		old.arpt_str_tbl = arpt_file.data() + (arpt_file.size() - arpt_hdr.str_sz);
+		old.arpt_str_sz = arpt_hdr.str_sz;
+		old.grps = rnw_file.data() + sizeof(arpt_cache_hdr_t);
+		old.rnws = old.grps + old.n_arpts * sizeof(arpt_cache_grp_t);
+		old.rnw_str_tbl = rnw_file.data() + (rnw_file.size() - rnw_hdr.str_sz);
+		old.rnw_str_sz = rnw_hdr.str_sz;
+
+		old.rnw_beg.resize(size_t(old.n_arpts + 1), 0);
+		for (size_t i = 0; i < old.n_arpts; i++)
+		{
+			arpt_cache_grp_t grp;
+			memcpy(&grp, old.grps + i * sizeof(arpt_cache_grp_t), sizeof(arpt_cache_grp_t));
+			old.rnw_beg[i + 1] = old.rnw_beg[i] + grp.n_rnws;
+		}
+		if (old.rnw_beg.back() != old.n_rnws)
+		{
+			return parse_sim_db(nullptr);
+		}
+
+		const char* sect_ptr = old.arpts + old.n_arpts * sizeof(arpt_cache_arpt_t);
+		old.sects.resize(size_t(arpt_hdr.n_sects));
+		old.sect_idx.reserve(size_t(arpt_hdr.n_sects));
+		for (size_t i = 0; i < old.sects.size(); i++)
+		{
+			memcpy(&old.sects[i], sect_ptr, sizeof(arpt_cache_sect_t));
+			sect_ptr += sizeof(arpt_cache_sect_t);
+			if (uint64_t(old.sects[i].arpt_idx) + uint64_t(old.sects[i].n_arpts) > old.n_arpts)
+			{
+				return parse_sim_db(nullptr);
+			}
+			old.sect_idx.insert(std::make_pair(old.sects[i].hash, i));
+		}
+
+		return parse_sim_db(&old);
+	}
+
+	int ArptDB::parse_sim_db(const arpt_cache_view_t* old)
+	{
+		MappedFile file(sim_arpt_db_path);
+		if (!file.is_open())
+		{
+			return 0;
+		}
+
+		const char* curr = file.data();
+		const char* end = curr + file.size();
+		for (int i = 0; i < N_ARPT_LINES_IGNORE && curr < end; i++)
+		{
+			size_t line_len;
+			const char* line = curr;
+			curr = strutils::next_line(curr, end, &line_len);
+
+			std::string line_str(line, line_len);
+			int tmp = get_db_version(line_str);
+			if(tmp)
+				db_version = tmp;
+		}
+
+		std::vector<const char*> chunks = get_arpt_chunks(curr, end, n_load_threads);
+		std::vector<arpt_shard_t> shards(n_load_threads);
+		std::vector<std::future<void>> tasks;
+		for (size_t i = 1; i < n_load_threads; i++)
+		{
+			if (old == nullptr)
+			{
+				tasks.push_back(std::async(std::launch::async, load_arpt_chunk, chunks[i], 
+					chunks[i+1], chunks[i+1] != end, min_rwy_length_m, &shards[i]));
+			}
+			else
+			{
+				tasks.push_back(std::async(std::launch::async, update_arpt_chunk, chunks[i], 
+					chunks[i+1], chunks[i+1] != end, min_rwy_length_m, old, &shards[i]));
+			}
+		}
+		if (old == nullptr)
+		{
+			load_arpt_chunk(chunks[0], chunks[1], chunks[1] != end, min_rwy_length_m, 
+				&shards[0]);
+		}
+		else
+		{
+			update_arpt_chunk(chunks[0], chunks[1], chunks[1] != end, min_rwy_length_m, 
+				old, &shards[0]);
+		}
+		for (size_t i = 0; i < tasks.size(); i++)
+		{
+			tasks[i].get();
+		}
+
+		// Shards are merged in file order, so if an icao code appears more than once,
+		// the first airport is used regardless of the number of threads.
+		std::vector<arpt_cache_sect_t> sects;
+		size_t n_arpts = 0;
+		for (size_t i = 0; i < n_load_threads; i++)
+		{
+			arpt_shard_t& shard = shards[i];
+			for (size_t j = 0; j < shard.arpts.size(); j++)
+			{
+				str_arpt_data_t apt = std::make_pair(shard.arpts[j].icao, 
+					shard.arpts[j].data);
+				str_rnw_t rnw_pair = std::make_pair(shard.arpts[j].icao, 
+					std::move(shard.rnw_maps[j]));
+				arpt_db.insert(apt);
+				rnw_db.insert(rnw_pair);
+			}
+			for (size_t j = 0; j < shard.sects.size(); j++)
+			{
+				arpt_cache_sect_t tmp;
+				memset(&tmp, 0, sizeof(arpt_cache_sect_t));
+				tmp.src_offset = uint64_t(shard.sects[j].beg - file.data());
+				tmp.src_len = shard.sects[j].len;
+				tmp.hash = shard.sects[j].hash;
+				tmp.arpt_idx = uint32_t(n_arpts + shard.sects[j].arpt_idx);
+				tmp.n_arpts = uint32_t(shard.sects[j].n_arpts);
+				tmp.has_icao = uint32_t(shard.sects[j].has_icao);
+				sects.push_back(tmp);
+			}
+			n_arpts += shard.arpts.size();
+			add_to_arpt_queue(shard.arpts);
+			add_to_rnw_queue(shard.rnws);
+			if (shard.is_last)
+			{
+				break;
+			}
+		}
+		// The writer reads the sections once the queues have been closed
+		arpt_sects = std::move(sects);
+		return 1;
+	}
+
+	void ArptDB::load_arpt_chunk(const char* beg, const char* end, bool flush, 
+		double min_rwy_l_m, arpt_shard_t* out)
+	{
+		airport_t tmp_arpt = { "", {{0, 0}, 0, 0, 0} };
+		rnw_data_t tmp_rnw = { "", {} };
+		double max_rnw_length_m = 0;
+		const char* sect_beg = beg;
+		size_t sect_arpt_idx = out->arpts.size();
+
+		while (beg < end)
+		{
+			size_t line_len;
+			const char* line = beg;
+			beg = strutils::next_line(beg, end, &line_len);
+
+			// Most of the rows describe taxiways, signs, etc. Only the row code is 
+			// read from those.
+			strutils::str_view_t s_split[N_MISC_DATA_ITEMS];
+			if (get_apt_words(line, line_len, s_split, 1) == 0)
+			{
+				continue;
+			}
+			int row_code = strutils::view_to_int(s_split[0]);
+
+			bool is_offload = tmp_arpt.icao != "" && tmp_rnw.icao != "" && 
+				(row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT)
+				 || row_code == static_cast<int>(XPLMArptRowCode::DB_EOF));
+			if (is_offload)
+			{
+				// Offload airport data
+				add_to_shard(tmp_arpt, tmp_rnw, max_rnw_length_m, min_rwy_l_m, out);
+
+				tmp_arpt.icao = "";
+				tmp_rnw.icao = "";
+				tmp_arpt.data.pos = { 0, 0 };
+				tmp_arpt.data.transition_alt_ft = 0;
+				tmp_arpt.data.transition_level = 0;
+				tmp_rnw.runways.clear();
+				max_rnw_length_m = 0;
+			}
+
+			// Parse data
+
+			if (row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT))
+			{
+				if (get_apt_words(line, line_len, s_split, 2) == 2)
+				{
+					// The header resets the parser, so it starts a new section
+					if (is_offload)
+					{
+						add_sect(sect_beg, line, true, sect_arpt_idx, true, out);
+						sect_beg = line;
+						sect_arpt_idx = out->arpts.size();
+					}
+					tmp_arpt.data.elevation_ft = uint32_t(strutils::view_to_int(s_split[1]));
+				}
+			}
+			else if (row_code == static_cast<int>(XPLMArptRowCode::MISC_DATA))
+			{
+				size_t n_words = get_apt_words(line, line_len, s_split, N_MISC_DATA_ITEMS);
+				if (n_words < N_MISC_DATA_ITEMS - 1)
+				{
+					continue;
+				}
+				// Values that are missing are read as empty strings
+				strutils::str_view_t var_name = s_split[1];
+				strutils::str_view_t value;
+				if (n_words == N_MISC_DATA_ITEMS)
+				{
+					value = s_split[2];
+				}
+
+				if (var_name == "icao_code")
+				{
+					tmp_arpt.icao = value.to_str();
+					tmp_rnw.icao = tmp_arpt.icao;
+				}
+				else if (var_name == "transition_alt")
+				{
+					tmp_arpt.data.transition_alt_ft = uint32_t(strutils::view_to_int(value));
+				}
+				else if (var_name == "transition_level")
+				{
+					tmp_arpt.data.transition_level = uint32_t(strutils::view_to_int(value));
+				}
+			}
+			else if (row_code == static_cast<int>(XPLMArptRowCode::LAND_RUNWAY)
+				 && tmp_arpt.icao != "")
+			{
+				double tmp = parse_runway(line, line_len, &tmp_rnw.runways);
+				if (tmp > max_rnw_length_m)
+				{
+					max_rnw_length_m = tmp;
+				}
+			}
+			else if (row_code == static_cast<int>(XPLMArptRowCode::DB_EOF))
+			{
+				add_sect(sect_beg, line, true, sect_arpt_idx, is_offload, out);
+				out->is_last = true;
+				return;
+			}
+		}
+
+		// The next chunk starts with an airport header, which would've offloaded 
+		// the last airport.
+		if (flush && tmp_arpt.icao != "" && tmp_rnw.icao != "")
+		{
+			add_to_shard(tmp_arpt, tmp_rnw, max_rnw_length_m, min_rwy_l_m, out);
+		}
+		add_sect(sect_beg, end, flush, sect_arpt_idx, tmp_arpt.icao != "", out);
+	}
+
+	void ArptDB::update_arpt_chunk(const char* beg, const char* end, bool flush, 
+		double min_rwy_l_m, const arpt_cache_view_t* old, arpt_shard_t* out)
+	{
+		// Sections that haven't changed are usually in the same order as before, so
+		// the section that follows the previous one in old is checked first. This
+		// doesn't require splitting the text into lines.
+		size_t next_idx = 0;
+		while (beg < end)
+		{
+			if (next_idx < old->sects.size() && 
+				is_same_sect(*old, next_idx, beg, end, flush) && 
+				copy_cache_sect(*old, next_idx, beg, out))
+			{
+				beg += old->sects[next_idx].src_len;
+				next_idx++;
+				continue;
+			}
+
+			const char* sect_end = get_next_sect(beg, end, true);
+			if (sect_end == beg)
+			{
+				// Only the terminating line can end a section at its first line
+				out->is_last = true;
+				return;
+			}
+
+			bool sect_flush = sect_end != end || flush;
+			size_t len = size_t(sect_end - beg);
+			auto it = old->sect_idx.find(get_sect_hash(beg, len, sect_flush));
+			if (it != old->sect_idx.end() && old->sects[it->second].src_len == len && 
+				copy_cache_sect(*old, it->second, beg, out))
+			{
+				next_idx = it->second + 1;
+			}
+			else
+			{
+				// The section has been changed or added
+				load_arpt_chunk(beg, sect_end, sect_flush, min_rwy_l_m, out);
+				next_idx++;
+			}
+			beg = sect_end;
+		}
+	}
+
+	bool ArptDB::is_same_sect(const arpt_cache_view_t& old, size_t idx, 
+		const char* beg, const char* end, bool flush)
+	{
+		const arpt_cache_sect_t& sect = old.sects[idx];
+		if (sect.src_len > uint64_t(end - beg))
+		{
+			return false;
+		}
+		const char* sect_end = beg + sect.src_len;
+
+		// The section must end at the same place as it would if the chunk was split 
+		// by get_next_sect.
+		if (sect_end != end)
+		{
+			if (sect_end[-1] != '\n')
+			{
+				return false;
+			}
+			size_t line_len;
+			strutils::next_line(sect_end, end, &line_len);
+			strutils::str_view_t s_split[2];
+			size_t n_words = get_apt_words(sect_end, line_len, s_split, 2);
+			int row_code = 0;
+			if (n_words)
+			{
+				row_code = strutils::view_to_int(s_split[0]);
+			}
+			bool is_arpt_end = row_code == static_cast<int>(XPLMArptRowCode::LAND_ARPT) && 
+				sect.has_icao && n_words == 2;
+			if (!is_arpt_end && row_code != static_cast<int>(XPLMArptRowCode::DB_EOF))
+			{
+				return false;
+			}
+			flush = true;
+		}
+
+		return get_sect_hash(beg, size_t(sect.src_len), flush) == sect.hash;
+	}
+
+	bool ArptDB::copy_cache_sect(const arpt_cache_view_t& old, size_t idx, 
+		const char* beg, arpt_shard_t* out)
+	{
+		const arpt_cache_sect_t& sect = old.sects[idx];
+		size_t arpt_idx = out->arpts.size();
+		for (uint32_t i = 0; i < sect.n_arpts; i++)
+		{
+			uint64_t src_idx = uint64_t(sect.arpt_idx) + i;
+			airport_t arpt;
+			rnw_data_t rnw;
+			runway_data rnw_map;
+			arpt_cache_grp_t grp;
+			memcpy(&grp, old.grps + src_idx * sizeof(arpt_cache_grp_t), 
+				sizeof(arpt_cache_grp_t));
+			bool is_valid = read_cache_arpt(old.arpts + src_idx * sizeof(arpt_cache_arpt_t), 
+				old.arpt_str_tbl, old.arpt_str_sz, &arpt) && 
+				get_cache_str(old.rnw_str_tbl, old.rnw_str_sz, grp.icao, &rnw.icao) && 
+				rnw.icao == arpt.icao;
+
+			for (uint64_t j = old.rnw_beg[size_t(src_idx)]; 
+				is_valid && j < old.rnw_beg[size_t(src_idx + 1)]; j++)
+			{
+				runway_t tmp;
+				is_valid = read_cache_rnw(old.rnws + j * sizeof(arpt_cache_rnw_t), 
+					old.rnw_str_tbl, old.rnw_str_sz, &tmp);
+				rnw_map.insert(std::make_pair(tmp.id, tmp.data));
+				rnw.runways.push_back(tmp);
+			}
+
+			if (!is_valid)
+			{
+				out->arpts.resize(arpt_idx);
+				out->rnws.resize(arpt_idx);
+				out->rnw_maps.resize(arpt_idx);
+				return false;
+			}
+			out->arpts.push_back(arpt);
+			out->rnws.push_back(std::move(rnw));
+			out->rnw_maps.push_back(std::move(rnw_map));
+		}
+
+		arpt_sect_t tmp;
+		tmp.beg = beg;
+		tmp.len = size_t(sect.src_len);
+		tmp.hash = sect.hash;
+		tmp.arpt_idx = arpt_idx;
+		tmp.n_arpts = sect.n_arpts;
+		tmp.has_icao = sect.has_icao != 0;
+		out->sects.push_back(tmp);
+		return true;
+	}
+
+	void ArptDB::add_sect(const char* beg, const char* end, bool flush, 
+		size_t arpt_idx, bool has_icao, arpt_shard_t* out)
+	{
+		if (beg == end)
+		{
+			return;
+		}
+		arpt_sect_t sect;
+		sect.beg = beg;
+		sect.len = size_t(end - beg);
+		sect.hash = get_sect_hash(beg, sect.len, flush);
+		sect.arpt_idx = arpt_idx;
+		sect.n_arpts = out->arpts.size() - arpt_idx;
+		sect.has_icao = has_icao;
+		out->sects.push_back(sect);
+	}
+
+	void ArptDB::add_to_shard(airport_t& arpt, rnw_data_t& rnw, double max_rnw_length_m, 
+		double min_rwy_l_m, arpt_shard_t* out)
+	{
+		if (max_rnw_length_m < min_rwy_l_m || arpt.data.transition_alt_ft + 
+			arpt.data.transition_level == 0)
+		{
+			return;
+		}
+
+		std::unordered_map<std::string, runway_entry_t> apt_runways;
+		size_t n_runways = rnw.runways.size();
+
+		for (size_t j = 0; j < n_runways; j++)
+		{
+			runway_t rwy = rnw.runways.at(j);
+			std::pair<std::string, runway_entry_t> tmp = std::make_pair(rwy.id, rwy.data);
+			apt_runways.insert(tmp);
+			arpt.data.pos.lat_rad += rwy.data.start.lat_rad;
+			arpt.data.pos.lon_rad += rwy.data.start.lon_rad;
+		}
+
+		arpt.data.pos.lat_rad /= double(n_runways);
+		arpt.data.pos.lon_rad /= double(n_runways);
+		arpt.data.store_nvec();
+
+		out->arpts.push_back(arpt);
+		out->rnws.push_back(rnw);
+		out->rnw_maps.push_back(std::move(apt_runways));
+	}
+
+	arpt_cache_str_t ArptDB::add_cache_str(std::string& str_tbl, const std::string& s)
+	{
+		arpt_cache_str_t out;
+		out.offset = uint32_t(str_tbl.size());
+		out.len = uint32_t(s.size());
+		str_tbl.append(s);
+		return out;
+	}
+
+	bool ArptDB::get_cache_str(const char* str_tbl, uint64_t str_sz, 
+		arpt_cache_str_t s, std::string* out)
+	{
+		if (uint64_t(s.offset) + uint64_t(s.len) > str_sz)
+		{
+			return false;
+		}
+		out->assign(str_tbl + s.offset, s.len);
+		return true;
+	}
+
+	bool ArptDB::read_cache_arpt(const char* rec, const char* str_tbl, uint64_t str_sz, 
+		airport_t* out)
+	{
+		arpt_cache_arpt_t tmp;
+		memcpy(&tmp, rec, sizeof(arpt_cache_arpt_t));
+		if (!get_cache_str(str_tbl, str_sz, tmp.icao, &out->icao))
+		{
+			return false;
+		}
+		out->data.pos.lat_rad = tmp.lat_rad;
+		out->data.pos.lon_rad = tmp.lon_rad;
+		out->data.elevation_ft = tmp.elevation_ft;
+		out->data.transition_alt_ft = tmp.transition_alt_ft;
+		out->data.transition_level = tmp.transition_level;
+		out->data.set_nvec({tmp.nv_x, tmp.nv_y, tmp.nv_z});
+		return true;
+	}
+
+	bool ArptDB::read_cache_rnw(const char* rec, const char* str_tbl, uint64_t str_sz, 
+		runway_t* out)
+	{
+		arpt_cache_rnw_t tmp;
+		memcpy(&tmp, rec, sizeof(arpt_cache_rnw_t));
+		if (!get_cache_str(str_tbl, str_sz, tmp.id, &out->id))
+		{
+			return false;
+		}
+		runway_entry_t& data = out->data;
+		data.start.lat_rad = tmp.start_lat_rad;
+		data.start.lon_rad = tmp.start_lon_rad;
+		data.end.lat_rad = tmp.end_lat_rad;
+		data.end.lon_rad = tmp.end_lon_rad;
+		data.displ_threshold_m = tmp.displ_threshold_m;
+		data.set_nvecs({tmp.start_nv_x, tmp.start_nv_y, tmp.start_nv_z}, 
+			{tmp.end_nv_x, tmp.end_nv_y, tmp.end_nv_z});
+		return true;
+	}
+
+	void ArptDB::add_to_arpt_queue(std::vector<airport_t>& batch)
+	{
+		if (!apt_db_created || batch.empty())
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(arpt_queue_mutex);
+			arpt_queue.insert(arpt_queue.end(), std::make_move_iterator(batch.begin()), 
+				std::make_move_iterator(batch.end()));
+		}
+		batch.clear();
+		arpt_queue_cv.notify_one();
+	}
+
+	void ArptDB::add_to_rnw_queue(std::vector<rnw_data_t>& batch)
+	{
+		if (!rnw_db_created || batch.empty())
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(rnw_queue_mutex);
+			rnw_queue.insert(rnw_queue.end(), std::make_move_iterator(batch.begin()), 
+				std::make_move_iterator(batch.end()));
+		}
+		batch.clear();
+		rnw_queue_cv.notify_one();
+	}
+
+	void ArptDB::close_queues()
+	{
+		{
+			std::lock_guard<std::mutex> arpt_lock(arpt_queue_mutex);
+			std::lock_guard<std::mutex> rnw_lock(rnw_queue_mutex);
+			queues_closed = true;
+		}
+		arpt_queue_cv.notify_one();
+		rnw_queue_cv.notify_one();
+	}
+
+	bool ArptDB::get_arpt_batch(std::vector<airport_t>* batch)
 	{
-		std::lock_guard<std::mutex> lock(arpt_queue_mutex);
-		arpt_queue.push_back(arpt);
+		std::unique_lock<std::mutex> lock(arpt_queue_mutex);
+		arpt_queue_cv.wait(lock, [this] { return queues_closed || !arpt_queue.empty(); });
+		std::swap(arpt_queue, *batch);
+		return !batch->empty();
 	}
 
-	void ArptDB::add_to_rnw_queue(rnw_data_t rnw)
+	bool ArptDB::get_rnw_batch(std::vector<rnw_data_t>* batch)
 	{
-		std::lock_guard<std::mutex> lock(rnw_queue_mutex);
-		rnw_queue.push_back(rnw);
+		std::unique_lock<std::mutex> lock(rnw_queue_mutex);
+		rnw_queue_cv.wait(lock, [this] { return queues_closed || !rnw_queue.empty(); });
+		std::swap(rnw_queue, *batch);
+		return !batch->empty();
 	}
 }; // namespace libnav
\ No newline at end of file
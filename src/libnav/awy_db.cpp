@@ -115,29 +115,36 @@ namespace libnav
         return awy_db;
     }
 
-    bool AwyDB::is_in_awy(std::string awy, std::string point)
+    bool AwyDB::is_in_awy(const std::string& awy, const std::string& point)
     {
-        if(awy_db.find(awy) != awy_db.end() && 
-            awy_db[awy].find(point) != awy_db[awy].end())
+        const graph_t* graph = find_awy(awy);
+        return graph != nullptr && graph->find(point) != graph->end();
+    }
+
+    const graph_t* AwyDB::find_awy(const std::string& awy)
+    {
+        auto it = awy_db.find(awy);
+        if(it != awy_db.end())
         {
-            return true;
+            return &it->second;
         }
-        return false;
+        return nullptr;
     }
 
-    size_t AwyDB::get_ww_path(std::string awy, std::string start, 
-        std::string end, std::vector<awy_point_t>* out)
+    size_t AwyDB::get_ww_path(const std::string& awy, const std::string& start, 
+        const std::string& end, std::vector<awy_point_t>* out)
     {
         if(is_in_awy(awy, start) && is_in_awy(awy, end))
         {
-            return get_path(awy, start, out, awy_wpt_to_wpt_func, &end);
+            std::string tgt = end;
+            return get_path(awy, start, out, awy_wpt_to_wpt_func, &tgt);
         }
 
         return 0;
     }
 
-    size_t AwyDB::get_aa_path(std::string awy, std::string start, 
-        std::string next_awy, std::vector<awy_point_t>* out)
+    size_t AwyDB::get_aa_path(const std::string& awy, const std::string& start, 
+        const std::string& next_awy, std::vector<awy_point_t>* out)
     {
         if(is_in_awy(awy, start))
         {
@@ -148,9 +155,29 @@ namespace libnav
         return 0;
     }
 
-    size_t AwyDB::get_path(std::string awy, std::string start, 
+    size_t AwyDB::get_path(const std::string& awy, const std::string& start, 
             std::vector<awy_point_t>* out, awy_path_func_t path_func, void* ref)
     {
+        // Lookups below don't use operator[], so that queries never modify awy_db
+        const graph_t* graph = find_awy(awy);
+        if(graph == nullptr)
+        {
+            return 0;
+        }
+        auto get_restr = [graph](const std::string& from, const std::string& to) -> 
+            alt_restr_t {
+            auto from_it = graph->find(from);
+            if(from_it != graph->end())
+            {
+                auto to_it = from_it->second.find(to);
+                if(to_it != from_it->second.end())
+                {
+                    return to_it->second;
+                }
+            }
+            return {0, 0};
+        };
+
         std::unordered_map<std::string, std::string> prev;
         std::unordered_map<std::string, int> used;
         std::queue<std::string> q;
@@ -173,9 +200,14 @@ namespace libnav
                 break;
             }
 
-            for(auto it: awy_db[awy][curr])
+            auto curr_it = graph->find(curr);
+            if(curr_it == graph->end())
+            {
+                continue;
+            }
+            for(auto& it: curr_it->second)
             {
-                std::string tmp = it.first;
+                const std::string& tmp = it.first;
                 if(used.find(tmp) == used.end())
                 {
                     prev[tmp] = curr;
@@ -189,13 +221,13 @@ namespace libnav
         {
             return 0;
         }
-        alt_restr_t r_past = awy_db[awy][prev[curr]][curr];
+        alt_restr_t r_past = get_restr(prev[curr], curr);
         while(prev[curr] != curr)
         {
             awy_point_t curr_wpt;
             curr_wpt.id = curr;
             curr_wpt.alt_restr = r_past;
-            r_past = awy_db[awy][prev[curr]][curr];
+            r_past = get_restr(prev[curr], curr);
             out_rev.push_back(curr_wpt);
             curr = prev[curr];
         }
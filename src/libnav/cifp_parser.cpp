@@ -258,7 +258,7 @@ namespace libnav
                 if(ret)
                 {
                     *out = {area_code, {NavaidType::APT, 0, apt_data.pos, 
-                        area_code, country_code}};
+                        intern_code(area_code), intern_code(country_code)}};
                     return true;
                 }
             }
@@ -559,8 +559,8 @@ namespace libnav
             out->data.pos = rwy_db[tmp].pos;
             out->id = tmp;
             out->data.type = NavaidType::RWY;
-            out->data.area_code = area_cd;
-            out->data.country_code = country_cd;
+            out->data.area_code = intern_code(area_cd);
+            out->data.country_code = intern_code(country_cd);
 
             return true;
         }
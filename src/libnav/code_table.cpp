@@ -0,0 +1,189 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of functions for the global code table.
+*/
+
+#include "libnav/code_table.hpp"
+#include <atomic>
+#include <mutex>
+#include <cstring>
+
+
+namespace libnav
+{
+	class CodeTable
+	{
+	public:
+		CodeTable()
+		{
+			for (size_t i = 0; i < CODE_TABLE_N_CHUNKS; i++)
+			{
+				chunks[i].store(nullptr, std::memory_order_relaxed);
+			}
+			n_codes.store(0, std::memory_order_relaxed);
+
+			intern(std::string());
+		}
+
+		CodeTable(const CodeTable&) = delete;
+
+		CodeTable& operator=(const CodeTable&) = delete;
+
+		code_id_t intern(std::string s)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+
+			auto it = ids.find(s);
+			if(it != ids.end())
+			{
+				return it->second;
+			}
+
+			uint32_t id = n_codes.load(std::memory_order_relaxed);
+			size_t chunk_idx = id / CODE_TABLE_CHUNK_SZ;
+			if(chunk_idx >= CODE_TABLE_N_CHUNKS)
+			{
+				return CODE_ID_EMPTY;
+			}
+			std::string* chunk = chunks[chunk_idx].load(std::memory_order_relaxed);
+			if(chunk == nullptr)
+			{
+				chunk = new std::string[CODE_TABLE_CHUNK_SZ];
+				chunks[chunk_idx].store(chunk, std::memory_order_release);
+			}
+			chunk[id % CODE_TABLE_CHUNK_SZ] = s;
+			ids[s] = id;
+			// Strings are written before the count is published, so readers 
+			// never see a partially constructed string.
+			n_codes.store(id + 1, std::memory_order_release);
+
+			return id;
+		}
+
+		bool find(const std::string& s, code_id_t* out)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+
+			auto it = ids.find(s);
+			if(it != ids.end())
+			{
+				*out = it->second;
+				return true;
+			}
+			return false;
+		}
+
+		const std::string& get(code_id_t id)
+		{
+			if(id >= n_codes.load(std::memory_order_acquire))
+			{
+				id = CODE_ID_EMPTY;
+			}
+			std::string* chunk = chunks[id / CODE_TABLE_CHUNK_SZ].load(
+				std::memory_order_acquire);
+			return chunk[id % CODE_TABLE_CHUNK_SZ];
+		}
+
+		~CodeTable()
+		{
+			for (size_t i = 0; i < CODE_TABLE_N_CHUNKS; i++)
+			{
+				delete[] chunks[i].load(std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		std::mutex mtx;
+		std::unordered_map<std::string, code_id_t> ids;
+		// Chunks are never moved, so references returned by get stay valid.
+		std::atomic<std::string*> chunks[CODE_TABLE_N_CHUNKS];
+		std::atomic<uint32_t> n_codes;
+	};
+
+
+	static CodeTable& get_code_table()
+	{
+		static CodeTable table;
+		return table;
+	}
+
+
+	code_id_t intern_code(const char* s, size_t len)
+	{
+		return get_code_table().intern(std::string(s, len));
+	}
+
+	code_id_t intern_code(const std::string& s)
+	{
+		return get_code_table().intern(s);
+	}
+
+	bool find_code(const std::string& s, code_id_t* out)
+	{
+		return get_code_table().find(s, out);
+	}
+
+	const std::string& get_code_str(code_id_t id)
+	{
+		return get_code_table().get(id);
+	}
+
+
+	// LocalCodeTable definitions:
+
+	LocalCodeTable::LocalCodeTable()
+	{
+		intern("", 0);
+	}
+
+	code_id_t LocalCodeTable::intern(const char* s, size_t len)
+	{
+		strutils::str_view_t key;
+		key.ptr = s;
+		key.len = len;
+		auto it = ids.find(key);
+		if(it != ids.end())
+		{
+			return it->second;
+		}
+
+		code_id_t id = code_id_t(codes.size());
+		codes.push_back(std::string(s, len));
+		key.ptr = codes.back().data();
+		ids[key] = id;
+		return id;
+	}
+
+	std::vector<code_id_t> LocalCodeTable::get_global_ids() const
+	{
+		std::vector<code_id_t> out(codes.size());
+		for (size_t i = 0; i < codes.size(); i++)
+		{
+			out[i] = intern_code(codes[i]);
+		}
+		return out;
+	}
+
+	size_t LocalCodeTable::view_hash_t::operator()(const strutils::str_view_t& s) const
+	{
+		// FNV-1a. Codes are only a few characters long.
+		size_t h = size_t(14695981039346656037ULL);
+		for (size_t i = 0; i < s.len; i++)
+		{
+			h = (h ^ size_t(uint8_t(s.ptr[i]))) * size_t(1099511628211ULL);
+		}
+		return h;
+	}
+
+	bool LocalCodeTable::view_eq_t::operator()(const strutils::str_view_t& a, 
+		const strutils::str_view_t& b) const
+	{
+		return a.len == b.len && (a.len == 0 || !memcmp(a.ptr, b.ptr, a.len));
+	}
+}; // namespace libnav
@@ -0,0 +1,248 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of member functions for CoverageGrid class.
+*/
+
+#include "libnav/coverage_grid.hpp"
+
+
+namespace radnav_util
+{
+	// Distances from the centers of the cells to their corners are multiplied
+	// by this, so that rounding can't exclude stations at the edge of the range.
+	constexpr double COV_GRID_CELL_RAD_MARGIN = 1.0001;
+
+
+	CoverageGrid::CoverageGrid(std::shared_ptr<libnav::NavaidDB> db,
+		libnav::NavaidType type, double cell_deg, double band_ft, size_t n_bands)
+	{
+		navaid_db = db;
+		stn_type = type;
+		if(cell_deg <= 0)
+		{
+			cell_deg = COV_GRID_CELL_DEG;
+		}
+		if(band_ft <= 0)
+		{
+			band_ft = COV_GRID_BAND_FT;
+		}
+		cell_rad = cell_deg * geo::DEG_TO_RAD;
+		band_height_ft = band_ft;
+		n_bands_total = std::min(std::max(n_bands, size_t(1)), COV_GRID_MAX_BANDS);
+		n_lat = size_t(ceil(180 / cell_deg));
+		n_lon = size_t(ceil(360 / cell_deg));
+		is_grid_built = false;
+	}
+
+	bool CoverageGrid::build()
+	{
+		is_grid_built = false;
+		stations.clear();
+		items.clear();
+		cell_beg = std::vector<uint32_t>(n_lat * n_lon + 1, 0);
+
+		if(!navaid_db->is_frozen())
+		{
+			return false;
+		}
+
+		for (auto& it: navaid_db->get_db())
+		{
+			for (auto& entry: it.second)
+			{
+				if(entry.navaid != nullptr &&
+					(static_cast<int>(entry.type) & static_cast<int>(stn_type)))
+				{
+					stations.push_back({it.first, entry, -1});
+				}
+			}
+		}
+
+		// Cells in range of a station are found using a spatial index of their centers
+		size_t n_cells = n_lat * n_lon;
+		std::vector<geo::point> ctrs(n_cells);
+		for (size_t i = 0; i < n_lat; i++)
+		{
+			for (size_t j = 0; j < n_lon; j++)
+			{
+				ctrs[i * n_lon + j] = {-M_PI / 2 + (double(i) + 0.5) * cell_rad,
+					-M_PI + (double(j) + 0.5) * cell_rad};
+			}
+		}
+		libnav::GeoGrid ctr_grid;
+		ctr_grid.build(ctrs);
+
+		// Cells are largest at the equator
+		geo::point eq_ctr = {0, 0};
+		double cell_rad_nm = eq_ctr.get_gc_dist_nm({cell_rad / 2, cell_rad / 2}) *
+			COV_GRID_CELL_RAD_MARGIN;
+
+		std::vector<uint32_t> item_cells;
+		std::vector<libnav::geo_grid_res_t> found;
+		for (size_t i = 0; i < stations.size(); i++)
+		{
+			found.clear();
+			ctr_grid.get_in_radius(stations[i].data.pos,
+				stations[i].data.navaid->max_recv + cell_rad_nm, &found);
+			for (size_t j = 0; j < found.size(); j++)
+			{
+				double d_min_nm = std::max(found[j].dist_nm - cell_rad_nm, 0.0);
+				double d_max_nm = found[j].dist_nm + cell_rad_nm;
+				uint32_t mask = get_band_mask(stations[i], d_min_nm, d_max_nm);
+				if(mask)
+				{
+					item_cells.push_back(uint32_t(found[j].idx));
+					items.push_back({uint32_t(i), mask});
+				}
+			}
+		}
+
+		// Counting sort by cell
+		for (size_t i = 0; i < item_cells.size(); i++)
+		{
+			cell_beg[item_cells[i] + 1]++;
+		}
+		for (size_t i = 0; i < n_cells; i++)
+		{
+			cell_beg[i + 1] += cell_beg[i];
+		}
+		std::vector<uint32_t> cell_fill(cell_beg.begin(), cell_beg.end() - 1);
+		std::vector<cell_item_t> sorted(items.size());
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			sorted[cell_fill[item_cells[i]]++] = items[i];
+		}
+		std::swap(items, sorted);
+
+		is_grid_built = true;
+		return true;
+	}
+
+	bool CoverageGrid::is_built()
+	{
+		return is_grid_built;
+	}
+
+	size_t CoverageGrid::get_n_stations()
+	{
+		return stations.size();
+	}
+
+	const navaid_t& CoverageGrid::get_station(size_t idx)
+	{
+		return stations[idx];
+	}
+
+	size_t CoverageGrid::get_candidates(geo::point3d ac_pos, std::vector<size_t>* out)
+	{
+		out->clear();
+		if(!is_grid_built)
+		{
+			return 0;
+		}
+
+		size_t cell = get_cell(ac_pos.p);
+		uint32_t band_bit = uint32_t(1) << get_band(ac_pos.alt_ft);
+		for (uint32_t i = cell_beg[cell]; i < cell_beg[cell + 1]; i++)
+		{
+			if(items[i].band_mask & band_bit)
+			{
+				out->push_back(items[i].stn_idx);
+			}
+		}
+		return out->size();
+	}
+
+	size_t CoverageGrid::get_receivable(geo::point3d ac_pos,
+		std::vector<coverage_res_t>* out)
+	{
+		out->clear();
+		if(!is_grid_built)
+		{
+			return 0;
+		}
+
+		size_t cell = get_cell(ac_pos.p);
+		uint32_t band_bit = uint32_t(1) << get_band(ac_pos.alt_ft);
+		geo::nvec ac_nv = ac_pos.p.get_nvec();
+		for (uint32_t i = cell_beg[cell]; i < cell_beg[cell + 1]; i++)
+		{
+			if(!(items[i].band_mask & band_bit))
+			{
+				continue;
+			}
+			size_t idx = items[i].stn_idx;
+			double qual = get_navaid_qual(stations[idx].data, ac_pos, ac_nv);
+			if(qual >= 0)
+			{
+				out->push_back({idx, qual});
+			}
+		}
+		return out->size();
+	}
+
+	// Private member functions:
+
+	size_t CoverageGrid::get_cell(geo::point p)
+	{
+		double row = floor((p.lat_rad + M_PI / 2) / cell_rad);
+		double lon_norm = p.lon_rad - 2 * M_PI * floor((p.lon_rad + M_PI) / (2 * M_PI));
+		double col = floor((lon_norm + M_PI) / cell_rad);
+		row = std::min(std::max(row, 0.0), double(n_lat - 1));
+		col = std::min(std::max(col, 0.0), double(n_lon - 1));
+		return size_t(row) * n_lon + size_t(col);
+	}
+
+	size_t CoverageGrid::get_band(double alt_ft)
+	{
+		double band = floor(alt_ft / band_height_ft);
+		band = std::min(std::max(band, 0.0), double(n_bands_total - 1));
+		return size_t(band);
+	}
+
+	uint32_t CoverageGrid::get_band_mask(const navaid_t& stn, double d_min_nm,
+		double d_max_nm)
+	{
+		double elev_ft = stn.data.navaid->elev_ft;
+		double max_recv_nm = stn.data.navaid->max_recv;
+		double tan_slant = tan(libnav::VOR_MAX_SLANT_ANGLE_DEG * geo::DEG_TO_RAD);
+
+		uint32_t mask = 0;
+		for (size_t i = 0; i < n_bands_total; i++)
+		{
+			// Smallest vertical distance between the station and the band. The first
+			// band has no lower limit and the last one has no upper limit.
+			double band_lo_ft = double(i) * band_height_ft;
+			double band_hi_ft = double(i + 1) * band_height_ft;
+			double v_min_ft = 0;
+			if(i != 0 && elev_ft < band_lo_ft)
+			{
+				v_min_ft = band_lo_ft - elev_ft;
+			}
+			else if(i + 1 != n_bands_total && elev_ft > band_hi_ft)
+			{
+				v_min_ft = elev_ft - band_hi_ft;
+			}
+			double v_min_nm = v_min_ft * geo::FT_TO_NM;
+
+			// Out of range everywhere in the cell
+			if(d_min_nm * d_min_nm + v_min_nm * v_min_nm > max_recv_nm * max_recv_nm)
+			{
+				continue;
+			}
+			// Above VOR_MAX_SLANT_ANGLE_DEG everywhere in the cell
+			if(d_max_nm * tan_slant < v_min_nm)
+			{
+				continue;
+			}
+			mask |= uint32_t(1) << i;
+		}
+		return mask;
+	}
+}; // namespace radnav_util
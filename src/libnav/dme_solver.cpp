@@ -0,0 +1,208 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of member functions for DmeSolver class.
+*/
+
+#include "libnav/dme_solver.hpp"
+#include "libnav/navaid_db.hpp"
+
+
+namespace radnav_util
+{
+	inline dme_vec_t get_ec_vec(geo::point p, double radius_nm)
+	{
+		double cos_lat = cos(p.lat_rad);
+		return {radius_nm * cos_lat * cos(p.lon_rad),
+			radius_nm * cos_lat * sin(p.lon_rad), radius_nm * sin(p.lat_rad)};
+	}
+
+	inline geo::point get_ec_point(dme_vec_t v)
+	{
+		double len = sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+		return {asin(v.z / len), atan2(v.y, v.x)};
+	}
+
+
+	DmeSolver::DmeSolver(size_t max_iter, double tol_nm)
+	{
+		n_iter_max = max_iter;
+		tol = tol_nm;
+		has_guess = false;
+		guess = {0, 0};
+	}
+
+	void DmeSolver::reset()
+	{
+		has_guess = false;
+	}
+
+	void DmeSolver::set_guess(geo::point pos)
+	{
+		guess = pos;
+		has_guess = true;
+	}
+
+	bool DmeSolver::solve(const std::vector<dme_meas_t>& meas, double ac_alt_ft,
+		dme_fix_t* out)
+	{
+		if(meas.size() < 2)
+		{
+			return false;
+		}
+
+		geo::point pos = guess;
+		if(!has_guess && !get_start_pos(meas, ac_alt_ft, &pos))
+		{
+			return false;
+		}
+
+		// Measurements are weighted by the inverse variance of the DME error
+		st_vec.resize(meas.size());
+		weights.resize(meas.size());
+		for (size_t i = 0; i < meas.size(); i++)
+		{
+			st_vec[i] = get_ec_vec(meas[i].pos,
+				geo::EARTH_RADIUS_NM + meas[i].elev_ft * geo::FT_TO_NM);
+			double sigma_nm = get_dme_fom(meas[i].dist_nm) / 2;
+			weights[i] = 1 / (sigma_nm * sigma_nm);
+		}
+
+		// Gauss-Newton iterations. Position corrections are calculated in the
+		// local east/north plane of the current estimate.
+		double ac_rad_nm = geo::EARTH_RADIUS_NM + ac_alt_ft * geo::FT_TO_NM;
+		double a_ee = 0, a_en = 0, a_nn = 0, det = 0;
+		bool is_conv = false;
+		size_t n_iter = 0;
+		while (n_iter < n_iter_max && !is_conv)
+		{
+			double sin_lat = sin(pos.lat_rad), cos_lat = cos(pos.lat_rad);
+			double sin_lon = sin(pos.lon_rad), cos_lon = cos(pos.lon_rad);
+			dme_vec_t east = {-sin_lon, cos_lon, 0};
+			dme_vec_t north = {-sin_lat * cos_lon, -sin_lat * sin_lon, cos_lat};
+			dme_vec_t ac_vec = {ac_rad_nm * cos_lat * cos_lon,
+				ac_rad_nm * cos_lat * sin_lon, ac_rad_nm * sin_lat};
+
+			double b_e = 0, b_n = 0;
+			a_ee = 0;
+			a_en = 0;
+			a_nn = 0;
+			for (size_t i = 0; i < meas.size(); i++)
+			{
+				dme_vec_t d = {ac_vec.x - st_vec[i].x, ac_vec.y - st_vec[i].y,
+					ac_vec.z - st_vec[i].z};
+				double rho = sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+				if(rho == 0)
+				{
+					continue;
+				}
+				// Derivatives of the range by east and north displacement
+				double h_e = (d.x * east.x + d.y * east.y + d.z * east.z) / rho;
+				double h_n = (d.x * north.x + d.y * north.y + d.z * north.z) / rho;
+				double res = meas[i].dist_nm - rho;
+				double w = weights[i];
+
+				a_ee += w * h_e * h_e;
+				a_en += w * h_e * h_n;
+				a_nn += w * h_n * h_n;
+				b_e += w * h_e * res;
+				b_n += w * h_n * res;
+			}
+
+			det = a_ee * a_nn - a_en * a_en;
+			double trace = a_ee + a_nn;
+			if(!(det > DME_SOLVER_MIN_DET_RATIO * trace * trace))
+			{
+				return false;
+			}
+
+			double dx_e = (a_nn * b_e - a_en * b_n) / det;
+			double dx_n = (a_ee * b_n - a_en * b_e) / det;
+			ac_vec.x += dx_e * east.x + dx_n * north.x;
+			ac_vec.y += dx_e * east.y + dx_n * north.y;
+			ac_vec.z += dx_e * east.z + dx_n * north.z;
+			pos = get_ec_point(ac_vec);
+
+			n_iter++;
+			is_conv = sqrt(dx_e * dx_e + dx_n * dx_n) < tol;
+		}
+
+		if(!is_conv)
+		{
+			return false;
+		}
+
+		out->pos = pos;
+		out->cov_ee = a_nn / det;
+		out->cov_en = -a_en / det;
+		out->cov_nn = a_ee / det;
+		out->fom_nm = 2 * sqrt(out->cov_ee + out->cov_nn);
+		out->rms_res_nm = get_rms_res(meas, pos, ac_alt_ft);
+		out->n_iter = n_iter;
+
+		guess = pos;
+		has_guess = true;
+
+		return true;
+	}
+
+	// Private member functions:
+
+	bool DmeSolver::get_start_pos(const std::vector<dme_meas_t>& meas, double ac_alt_ft,
+		geo::point* out)
+	{
+		double best_res = -1;
+		for (size_t i = 0; i + 1 < meas.size() && best_res < 0; i++)
+		{
+			for (size_t j = i + 1; j < meas.size() && best_res < 0; j++)
+			{
+				// get_dme_dme_pos expects the westmost DME first
+				const dme_meas_t* dme_u = &meas[i];
+				const dme_meas_t* dme_s = &meas[j];
+				if(dme_u->pos.lon_rad > dme_s->pos.lon_rad)
+				{
+					std::swap(dme_u, dme_s);
+				}
+
+				geo::point cand[2];
+				int n_cand = geo::get_dme_dme_pos(dme_u->pos, dme_s->pos,
+					dme_u->dist_nm, dme_s->dist_nm, dme_u->elev_ft, dme_s->elev_ft,
+					ac_alt_ft, cand);
+				for (int k = 0; k < n_cand; k++)
+				{
+					double res = get_rms_res(meas, cand[k], ac_alt_ft);
+					// Inconsistent ranges produce NaNs
+					if(!(res >= 0))
+					{
+						continue;
+					}
+					if(best_res < 0 || res < best_res)
+					{
+						best_res = res;
+						*out = cand[k];
+					}
+				}
+			}
+		}
+
+		return best_res >= 0;
+	}
+
+	double DmeSolver::get_rms_res(const std::vector<dme_meas_t>& meas, geo::point pos,
+		double ac_alt_ft)
+	{
+		double sum_sq = 0;
+		for (size_t i = 0; i < meas.size(); i++)
+		{
+			double res = meas[i].dist_nm -
+				pos.get_line_dist_nm(meas[i].pos, ac_alt_ft, meas[i].elev_ft);
+			sum_sq += res * res;
+		}
+		return sqrt(sum_sq / double(meas.size()));
+	}
+}; // namespace radnav_util
@@ -0,0 +1,120 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of batch FOM functions.
+*/
+
+#include "libnav/fom_batch.hpp"
+#include "libnav/navaid_db.hpp"
+#include "libnav/simd_utils.hpp"
+#include <cmath>
+
+
+namespace radnav_util
+{
+	// These must match the constants used by the scalar functions
+	constexpr double DME_FOM_MIN_SQ = 0.085 * 0.085;
+	constexpr double DME_FOM_BIAS_SQ = 0.05 * 0.05;
+	constexpr double DME_FOM_DIST_COEFF = 0.00125;
+	constexpr double VOR_FOM_DIST_COEFF_1 = 0.0122;
+	constexpr double VOR_FOM_DIST_COEFF_2 = 0.0175;
+
+
+#ifdef LIBNAV_SIMD
+	using namespace simd_utils;
+
+	inline vec_t get_dme_fom_vec(vec_t dist_nm)
+	{
+		vec_t tmp = vec_mul(vec_set(DME_FOM_DIST_COEFF), dist_nm);
+		vec_t max_val = vec_max(vec_mul(tmp, tmp), vec_set(DME_FOM_MIN_SQ));
+		vec_t variance = vec_add(vec_set(DME_FOM_BIAS_SQ), max_val);
+		return vec_mul(vec_sqrt(variance), vec_set(2));
+	}
+
+	inline vec_t get_vor_fom_vec(vec_t dist_nm)
+	{
+		vec_t v1 = vec_mul(vec_set(VOR_FOM_DIST_COEFF_1), dist_nm);
+		vec_t v2 = vec_mul(vec_set(VOR_FOM_DIST_COEFF_2), dist_nm);
+		vec_t variance = vec_add(vec_mul(v1, v1), vec_mul(v2, v2));
+		return vec_mul(vec_sqrt(variance), vec_set(2));
+	}
+#endif
+
+
+	void get_dme_fom_batch(const double* dist_nm, size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			vec_store(out + i, get_dme_fom_vec(vec_load(dist_nm + i)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = get_dme_fom(dist_nm[i]);
+		}
+	}
+
+	void get_vor_fom_batch(const double* dist_nm, size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			vec_store(out + i, get_vor_fom_vec(vec_load(dist_nm + i)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = get_vor_fom(dist_nm[i]);
+		}
+	}
+
+	void get_vor_dme_fom_batch(const double* dist_nm, size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			vec_t dist = vec_load(dist_nm + i);
+			vec_store(out + i, vec_max(get_vor_fom_vec(dist), get_dme_fom_vec(dist)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = get_vor_dme_fom(dist_nm[i]);
+		}
+	}
+
+	void get_dme_dme_fom_batch(const double* dist1_nm, const double* dist2_nm,
+		const double* phi_rad, size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			// There is no vector sine, so only the rest is vectorized
+			double sin_phi[N_VEC_LANES];
+			for (size_t j = 0; j < N_VEC_LANES; j++)
+			{
+				sin_phi[j] = sin(phi_rad[i + j]);
+			}
+			vec_t sin_vec = vec_load(sin_phi);
+			vec_t dme1_fom = get_dme_fom_vec(vec_load(dist1_nm + i));
+			vec_t dme2_fom = get_dme_fom_vec(vec_load(dist2_nm + i));
+			vec_t fom = vec_div(vec_max(dme1_fom, dme2_fom), sin_vec);
+			vec_store(out + i, vec_and_nonzero(fom, sin_vec));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = get_dme_dme_fom(dist1_nm[i], dist2_nm[i], phi_rad[i]);
+		}
+	}
+}; // namespace radnav_util
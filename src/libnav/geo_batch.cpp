@@ -0,0 +1,195 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of batch great circle functions.
+*/
+
+#include "libnav/geo_batch.hpp"
+#include "libnav/simd_utils.hpp"
+
+
+namespace geo
+{
+#ifdef LIBNAV_SIMD
+	using namespace simd_utils;
+
+	// The polynomials below are taken from the Cephes math library.
+
+	// pi/2 split into 3 parts for exact range reduction
+	constexpr double PIO2_1 = 1.57079625129699707031E0;
+	constexpr double PIO2_2 = 7.54978941586159635336E-8;
+	constexpr double PIO2_3 = 5.39030285815811905290E-15;
+
+	constexpr double SIN_COEFF[] = {1.58962301576546568060E-10, -2.50507477628578072866E-8,
+		2.75573136213857245213E-6, -1.98412698295895385996E-4,
+		8.33333333332211858878E-3, -1.66666666666666307295E-1};
+	constexpr double COS_COEFF[] = {-1.13585365213876817300E-11, 2.08757008419747316778E-9,
+		-2.75573141792967388112E-7, 2.48015872888517045348E-5,
+		-1.38888888888730564116E-3, 4.16666666666665929218E-2};
+
+	constexpr double ATAN_P[] = {-8.750608600031904122785E-1, -1.615753718733365076637E1,
+		-7.500855792314704667340E1, -1.228866684490136173410E2,
+		-6.485021904942025371773E1};
+	constexpr double ATAN_Q[] = {2.485846490142306297962E1, 1.650270098316988542046E2,
+		4.328810604912902668951E2, 4.853903996359136964868E2,
+		1.945506571482613964425E2};
+	constexpr double ATAN_MOREBITS = 6.123233995736765886130E-17;
+
+
+	template<size_t N>
+	inline vec_t vec_poly(vec_t x, const double (&coeff)[N])
+	{
+		vec_t out = vec_set(coeff[0]);
+		for (size_t i = 1; i < N; i++)
+		{
+			out = vec_add(vec_mul(out, x), vec_set(coeff[i]));
+		}
+		return out;
+	}
+
+	// Calculates sine and cosine of x. |x| must be well below 2^51.
+	inline void vec_sincos(vec_t x, vec_t* s, vec_t* c)
+	{
+		vec_t q = vec_round(vec_mul(x, vec_set(2 / M_PI)));
+		vec_t r = vec_sub(x, vec_mul(q, vec_set(PIO2_1)));
+		r = vec_sub(r, vec_mul(q, vec_set(PIO2_2)));
+		r = vec_sub(r, vec_mul(q, vec_set(PIO2_3)));
+
+		// |r| <= pi/4
+		vec_t z = vec_mul(r, r);
+		vec_t sin_r = vec_add(r, vec_mul(vec_mul(r, z), vec_poly(z, SIN_COEFF)));
+		vec_t cos_r = vec_add(vec_sub(vec_set(1), vec_mul(vec_set(0.5), z)),
+			vec_mul(vec_mul(z, z), vec_poly(z, COS_COEFF)));
+
+		// m = q mod 4 in [-2, 2]
+		vec_t m = vec_sub(q, vec_mul(vec_round(vec_mul(q, vec_set(0.25))), vec_set(4)));
+		vec_t is_odd = vec_cmp_eq(vec_abs(m), vec_set(1));
+		vec_t neg_sin = vec_or(vec_cmp_lt(m, vec_set(-0.5)), vec_cmp_gt(m, vec_set(1.5)));
+		vec_t neg_cos = vec_or(vec_cmp_gt(m, vec_set(0.5)), vec_cmp_lt(m, vec_set(-1.5)));
+		vec_t sign = vec_set(-0.0);
+
+		*s = vec_xor(vec_select(is_odd, cos_r, sin_r), vec_and(neg_sin, sign));
+		*c = vec_xor(vec_select(is_odd, sin_r, cos_r), vec_and(neg_cos, sign));
+	}
+
+	// Calculates atan(x) for x in [0, 1]
+	inline vec_t vec_atan_01(vec_t x)
+	{
+		vec_t is_big = vec_cmp_gt(x, vec_set(0.66));
+		x = vec_select(is_big, vec_div(vec_sub(x, vec_set(1)), vec_add(x, vec_set(1))), x);
+		vec_t z = vec_mul(x, x);
+		vec_t p = vec_mul(z, vec_poly(z, ATAN_P));
+		vec_t q = vec_add(vec_mul(vec_add(z, vec_set(ATAN_Q[0])), z), vec_set(ATAN_Q[1]));
+		for (size_t i = 2; i < 5; i++)
+		{
+			q = vec_add(vec_mul(q, z), vec_set(ATAN_Q[i]));
+		}
+		vec_t out = vec_add(x, vec_mul(x, vec_div(p, q)));
+		vec_t y0 = vec_and(is_big, vec_set(M_PI / 4 + 0.5 * ATAN_MOREBITS));
+		return vec_add(y0, out);
+	}
+
+	inline vec_t vec_atan2(vec_t y, vec_t x)
+	{
+		vec_t abs_y = vec_abs(y);
+		vec_t abs_x = vec_abs(x);
+		vec_t max_val = vec_max(abs_y, abs_x);
+		vec_t ratio = vec_div(vec_min(abs_y, abs_x), max_val);
+		ratio = vec_andnot(vec_cmp_eq(max_val, vec_set(0)), ratio);
+
+		vec_t out = vec_atan_01(ratio);
+		out = vec_select(vec_cmp_gt(abs_y, abs_x), vec_sub(vec_set(M_PI / 2), out), out);
+		out = vec_select(vec_cmp_lt(x, vec_set(0)), vec_sub(vec_set(M_PI), out), out);
+		return vec_xor(out, vec_and(y, vec_set(-0.0)));
+	}
+
+	inline vec_t get_ang_dist_vec(vec_t ref_lat, vec_t ref_lon, vec_t ref_cos_lat,
+		vec_t lat, vec_t lon)
+	{
+		vec_t sin_dlat, sin_dlon, cos_lat, tmp;
+		vec_sincos(vec_mul(vec_sub(lat, ref_lat), vec_set(0.5)), &sin_dlat, &tmp);
+		vec_sincos(vec_mul(vec_sub(lon, ref_lon), vec_set(0.5)), &sin_dlon, &tmp);
+		vec_sincos(lat, &tmp, &cos_lat);
+
+		vec_t a = vec_add(vec_mul(sin_dlat, sin_dlat),
+			vec_mul(vec_mul(ref_cos_lat, cos_lat), vec_mul(sin_dlon, sin_dlon)));
+		a = vec_min(vec_max(a, vec_set(0)), vec_set(1));
+		return vec_mul(vec_set(2), vec_atan2(vec_sqrt(a), vec_sqrt(vec_sub(vec_set(1), a))));
+	}
+#endif
+
+
+	void get_ang_dist_rad_batch(point ref, const double* lat_rad, const double* lon_rad,
+		size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		vec_t ref_lat = vec_set(ref.lat_rad);
+		vec_t ref_lon = vec_set(ref.lon_rad);
+		vec_t ref_cos_lat = vec_set(cos(ref.lat_rad));
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			vec_store(out + i, get_ang_dist_vec(ref_lat, ref_lon, ref_cos_lat,
+				vec_load(lat_rad + i), vec_load(lon_rad + i)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = ref.get_ang_dist_rad({lat_rad[i], lon_rad[i]});
+		}
+	}
+
+	void get_gc_dist_nm_batch(point ref, const double* lat_rad, const double* lon_rad,
+		size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		vec_t ref_lat = vec_set(ref.lat_rad);
+		vec_t ref_lon = vec_set(ref.lon_rad);
+		vec_t ref_cos_lat = vec_set(cos(ref.lat_rad));
+		vec_t radius = vec_set(EARTH_RADIUS_NM);
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			vec_t ang_dist = get_ang_dist_vec(ref_lat, ref_lon, ref_cos_lat,
+				vec_load(lat_rad + i), vec_load(lon_rad + i));
+			vec_store(out + i, vec_mul(ang_dist, radius));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = ref.get_gc_dist_nm({lat_rad[i], lon_rad[i]});
+		}
+	}
+
+	void get_gc_bearing_rad_batch(point ref, const double* lat_rad, const double* lon_rad,
+		size_t n, double* out)
+	{
+		size_t i = 0;
+#ifdef LIBNAV_SIMD
+		vec_t ref_lon = vec_set(ref.lon_rad);
+		vec_t ref_sin_lat = vec_set(sin(ref.lat_rad));
+		vec_t ref_cos_lat = vec_set(cos(ref.lat_rad));
+		for (; i + N_VEC_LANES <= n; i += N_VEC_LANES)
+		{
+			vec_t sin_dlon, cos_dlon, sin_lat, cos_lat;
+			vec_sincos(vec_sub(vec_load(lon_rad + i), ref_lon), &sin_dlon, &cos_dlon);
+			vec_sincos(vec_load(lat_rad + i), &sin_lat, &cos_lat);
+
+			vec_t a = vec_mul(sin_dlon, cos_lat);
+			vec_t b = vec_sub(vec_mul(ref_cos_lat, sin_lat),
+				vec_mul(vec_mul(ref_sin_lat, cos_lat), cos_dlon));
+			// Same as the scalar function: 0 if b == 0
+			vec_store(out + i, vec_and_nonzero(vec_atan2(a, b), b));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = ref.get_gc_bearing_rad({lat_rad[i], lon_rad[i]});
+		}
+	}
+}; // namespace geo
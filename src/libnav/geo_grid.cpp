@@ -0,0 +1,194 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of member functions for GeoGrid class.
+*/
+
+#include "libnav/geo_grid.hpp"
+#include <algorithm>
+
+
+namespace libnav
+{
+	GeoGrid::GeoGrid()
+	{
+		cell_beg = std::vector<uint32_t>(GEO_GRID_N_LAT * GEO_GRID_N_LON + 1, 0);
+	}
+
+	void GeoGrid::build(const std::vector<geo::point>& pts)
+	{
+		size_t n_cells = GEO_GRID_N_LAT * GEO_GRID_N_LON;
+		std::vector<uint32_t> cell_idx(pts.size());
+		cell_beg = std::vector<uint32_t>(n_cells + 1, 0);
+
+		// Counting sort by cell
+		for (size_t i = 0; i < pts.size(); i++)
+		{
+			size_t cell = get_lat_row(pts[i].lat_rad) * GEO_GRID_N_LON + 
+				get_lon_col(pts[i].lon_rad);
+			cell_idx[i] = uint32_t(cell);
+			cell_beg[cell+1]++;
+		}
+		for (size_t i = 0; i < n_cells; i++)
+		{
+			cell_beg[i+1] += cell_beg[i];
+		}
+
+		std::vector<uint32_t> cell_fill(cell_beg.begin(), cell_beg.end() - 1);
+		items = std::vector<item_t>(pts.size());
+		for (size_t i = 0; i < pts.size(); i++)
+		{
+			items[cell_fill[cell_idx[i]]++] = get_item(pts[i], i);
+		}
+	}
+
+	size_t GeoGrid::get_n_items()
+	{
+		return items.size();
+	}
+
+	size_t GeoGrid::get_in_radius(geo::point p, double dist_nm, 
+		std::vector<geo_grid_res_t>* out, geo_grid_filter_t filt_func, void* ref)
+	{
+		size_t n_found = 0;
+		double ang_rad = dist_nm / geo::EARTH_RADIUS_NM;
+		if(ang_rad < 0 || items.empty())
+		{
+			return 0;
+		}
+		// Cells are selected with a small margin, so that rounding can't exclude 
+		// items right on the search circle.
+		double ang_sel_rad = ang_rad + GEO_GRID_SEL_MARGIN_RAD;
+		// Compare chord lengths instead of arc lengths. Both grow monotonically
+		// with distance.
+		double max_chord_sq = geo::get_chord_sq(dist_nm);
+		geo::nvec ctr = p.get_nvec();
+
+		size_t row_beg = get_lat_row(p.lat_rad - ang_sel_rad);
+		size_t row_end = get_lat_row(p.lat_rad + ang_sel_rad);
+		bool all_lon = p.lat_rad + ang_sel_rad >= M_PI / 2 || 
+			p.lat_rad - ang_sel_rad <= -M_PI / 2;
+		double lon_dev_rad = M_PI;
+		if(!all_lon)
+		{
+			// Maximum longitude deviation of a spherical cap that doesn't contain a pole
+			double sin_dev = sin(ang_sel_rad) / cos(p.lat_rad);
+			all_lon = sin_dev >= 1;
+			if(!all_lon)
+			{
+				lon_dev_rad = asin(sin_dev) + GEO_GRID_SEL_MARGIN_RAD;
+			}
+		}
+
+		long n_lon = long(GEO_GRID_N_LON);
+		long col_beg = 0;
+		long col_end = n_lon - 1;
+		if(!all_lon)
+		{
+			double lon_norm = p.lon_rad - 2 * M_PI * floor((p.lon_rad + M_PI) / (2 * M_PI));
+			col_beg = long(floor((lon_norm - lon_dev_rad + M_PI) / GEO_GRID_CELL_RAD));
+			col_end = long(floor((lon_norm + lon_dev_rad + M_PI) / GEO_GRID_CELL_RAD));
+			if(col_end - col_beg + 1 >= n_lon)
+			{
+				col_beg = 0;
+				col_end = n_lon - 1;
+			}
+		}
+
+		for (size_t row = row_beg; row <= row_end; row++)
+		{
+			for (long col = col_beg; col <= col_end; col++)
+			{
+				size_t col_wrap = size_t(((col % n_lon) + n_lon) % n_lon);
+				size_t cell = row * GEO_GRID_N_LON + col_wrap;
+				for (uint32_t i = cell_beg[cell]; i < cell_beg[cell+1]; i++)
+				{
+					const item_t& curr = items[i];
+					double chord_sq = curr.pos.get_chord_sq(ctr);
+					if(chord_sq > max_chord_sq || 
+						(filt_func != nullptr && !filt_func(curr.idx, ref)))
+					{
+						continue;
+					}
+					double chord = sqrt(chord_sq);
+					if(chord > 2)
+					{
+						chord = 2;
+					}
+					double dist_nm_curr = 2 * asin(chord / 2) * geo::EARTH_RADIUS_NM;
+					out->push_back({curr.idx, dist_nm_curr});
+					n_found++;
+				}
+			}
+		}
+
+		return n_found;
+	}
+
+	size_t GeoGrid::get_k_nearest(geo::point p, size_t k, 
+		std::vector<geo_grid_res_t>* out, geo_grid_filter_t filt_func, void* ref)
+	{
+		if(k == 0 || items.empty())
+		{
+			return 0;
+		}
+
+		double max_dist_nm = M_PI * geo::EARTH_RADIUS_NM;
+		double dist_nm = GEO_GRID_KNN_START_NM;
+		std::vector<geo_grid_res_t> found;
+		while (true)
+		{
+			found.clear();
+			get_in_radius(p, dist_nm, &found, filt_func, ref);
+			// Everything within dist_nm has been found, so the k nearest items 
+			// are among the results.
+			if(found.size() >= k || dist_nm >= max_dist_nm)
+			{
+				break;
+			}
+			dist_nm *= GEO_GRID_KNN_RAD_MULT;
+		}
+
+		size_t n_out = std::min(k, found.size());
+		std::partial_sort(found.begin(), found.begin() + long(n_out), found.end(), 
+			[](const geo_grid_res_t& a, const geo_grid_res_t& b) -> bool {
+				return a.dist_nm < b.dist_nm;
+			});
+		out->insert(out->end(), found.begin(), found.begin() + long(n_out));
+
+		return n_out;
+	}
+
+	// Private member functions:
+
+	size_t GeoGrid::get_lat_row(double lat_rad)
+	{
+		double row = floor((lat_rad + M_PI / 2) / GEO_GRID_CELL_RAD);
+		if(row < 0)
+			return 0;
+		if(row >= double(GEO_GRID_N_LAT))
+			return GEO_GRID_N_LAT - 1;
+		return size_t(row);
+	}
+
+	size_t GeoGrid::get_lon_col(double lon_rad)
+	{
+		double lon_norm = lon_rad - 2 * M_PI * floor((lon_rad + M_PI) / (2 * M_PI));
+		double col = floor((lon_norm + M_PI) / GEO_GRID_CELL_RAD);
+		if(col < 0)
+			return 0;
+		if(col >= double(GEO_GRID_N_LON))
+			return GEO_GRID_N_LON - 1;
+		return size_t(col);
+	}
+
+	GeoGrid::item_t GeoGrid::get_item(geo::point p, size_t idx)
+	{
+		return {p.get_nvec(), idx};
+	}
+}; // namespace libnav
@@ -76,20 +76,31 @@ namespace libnav
         return hold_db;
     }
 
-    bool HoldDB::has_hold(std::string& wpt_id)
+    bool HoldDB::has_hold(const std::string& wpt_id)
     {
         return hold_db.find(wpt_id) != hold_db.end();
     }
 
-    std::vector<hold_data_t> HoldDB::get_hold_data(std::string& wpt_id)
+    std::vector<hold_data_t> HoldDB::get_hold_data(const std::string& wpt_id)
     {
-        if(hold_db.find(wpt_id) != hold_db.end())
+        const std::vector<hold_data_t>* holds = find_hold_data(wpt_id);
+        if(holds != nullptr)
         {
-            return hold_db[wpt_id];
+            return *holds;
         }
         return {};
     }
 
+    const std::vector<hold_data_t>* HoldDB::find_hold_data(const std::string& wpt_id)
+    {
+        auto it = hold_db.find(wpt_id);
+        if(it != hold_db.end())
+        {
+            return &it->second;
+        }
+        return nullptr;
+    }
+
     DbErr HoldDB::load_holds(std::string& db_path)
     {
         DbErr out_code = DbErr::SUCCESS;
@@ -15,6 +15,8 @@
 #pragma once
 
 #include <future>
+#include <mutex>
+#include <condition_variable>
 #include <fstream>
 #include <unordered_map>
 #include <vector>
@@ -23,26 +25,39 @@
 #include <sstream>
 #include <algorithm>
 #include <ctype.h>
+#include <cstring>
 #include "str_utils.hpp"
 #include "geo_utils.hpp"
 #include "common.hpp"
+#include "mmap_file.hpp"
 
 
 namespace libnav
 {
-	constexpr double DB_VERSION = 1.7; // Change this if you want to rebuild runway and airport data bases
+	constexpr double DB_VERSION = 2.1; // Change this if you want to rebuild runway and airport data bases
 	constexpr int N_ARPT_LINES_IGNORE = 3;
 	// N_HEADER_STR_WORDS is the number of words in a string declaring the data base
 	// version.
 	constexpr int N_HEADER_STR_WORDS = 4;
 	// Number of items to ignore at the beginning of the land runway declaration.
-	constexpr int N_RNW_ITEMS_IGNORE_BEGINNING = 8;
-	constexpr int N_RNW_ITEMS_IGNORE_END = 5;
+	constexpr size_t N_RNW_ITEMS_IGNORE_BEGINNING = 8;
+	constexpr size_t N_RNW_ITEMS_IGNORE_END = 5;
+	// Number of items describing each end of a land runway: id, latitude, longitude
+	// and displaced threshold length.
+	constexpr size_t N_RNW_END_ITEMS = 4;
+	constexpr size_t N_RNW_ITEMS = N_RNW_ITEMS_IGNORE_BEGINNING + 2 * N_RNW_END_ITEMS + 
+		N_RNW_ITEMS_IGNORE_END;
+	// Row code, name and value of a misc data row
+	constexpr size_t N_MISC_DATA_ITEMS = 3;
 	// Number of indices after the decimal in the string representation of a double number
 	constexpr int N_DOUBLE_OUT_PRECISION = 9;
 	// If the longest runway of the airport is less than this, the airport will not be included in the database
 	constexpr double MIN_RWY_LENGTH_M = 1000;
 	constexpr char DEFAULT_COMMENT_CHAR = '#';
+	// Custom data base file constants:
+	constexpr size_t ARPT_CACHE_SIGN_SZ = 8;
+	// Used to reject data bases written on a host with different byte order
+	constexpr uint32_t ARPT_CACHE_BYTE_ORDER = 0x01020304;
 
 
 	enum class XPLMArptRowCode 
@@ -59,12 +74,58 @@ namespace libnav
 		geo::point start, end;
 		int displ_threshold_m;
 		double impl_length_m = -1;
+#ifdef LIBNAV_STORE_NVEC
+		// Calculated once by ArptDB while loading. Use get_start_nvec and 
+		// get_end_nvec to access them.
+		geo::nvec start_nv = {}, end_nv = {};
+#endif
+
+		geo::nvec get_start_nvec() const
+		{
+#ifdef LIBNAV_STORE_NVEC
+			if (start_nv.is_set())
+				return start_nv;
+#endif
+			return start.get_nvec();
+		}
+
+		geo::nvec get_end_nvec() const
+		{
+#ifdef LIBNAV_STORE_NVEC
+			if (end_nv.is_set())
+				return end_nv;
+#endif
+			return end.get_nvec();
+		}
+
+		// Stores the n-vectors of start and end. Does nothing unless 
+		// LIBNAV_STORE_NVEC is defined.
+		void store_nvecs()
+		{
+#ifdef LIBNAV_STORE_NVEC
+			start_nv = start.get_nvec();
+			end_nv = end.get_nvec();
+#endif
+		}
+
+		// Same as store_nvecs, but the n-vectors are known
+		void set_nvecs(geo::nvec start_nvec, geo::nvec end_nvec)
+		{
+#ifdef LIBNAV_STORE_NVEC
+			start_nv = start_nvec;
+			end_nv = end_nvec;
+#else
+			(void)start_nvec;
+			(void)end_nvec;
+#endif
+		}
 
 		double get_impl_length_m()
 		{
 			if (impl_length_m <= 0)
 			{
-				impl_length_m = start.get_gc_dist_nm(end) * geo::NM_TO_M;
+				impl_length_m = get_start_nvec().get_gc_dist_nm(get_end_nvec()) * 
+					geo::NM_TO_M;
 			}
 			return impl_length_m;
 		}
@@ -82,6 +143,37 @@ namespace libnav
 	{
 		geo::point pos;
 		uint32_t elevation_ft, transition_alt_ft, transition_level;
+#ifdef LIBNAV_STORE_NVEC
+		// Calculated once by ArptDB while loading. Use get_nvec to access it.
+		geo::nvec pos_nv = {};
+#endif
+
+		geo::nvec get_nvec() const
+		{
+#ifdef LIBNAV_STORE_NVEC
+			if (pos_nv.is_set())
+				return pos_nv;
+#endif
+			return pos.get_nvec();
+		}
+
+		// Stores the n-vector of pos. Does nothing unless LIBNAV_STORE_NVEC is defined.
+		void store_nvec()
+		{
+#ifdef LIBNAV_STORE_NVEC
+			pos_nv = pos.get_nvec();
+#endif
+		}
+
+		// Same as store_nvec, but the n-vector is known
+		void set_nvec(geo::nvec nv)
+		{
+#ifdef LIBNAV_STORE_NVEC
+			pos_nv = nv;
+#else
+			(void)nv;
+#endif
+		}
 	};
 
 	struct airport_entry_t
@@ -108,6 +200,121 @@ namespace libnav
 		std::unordered_map<std::string, runway_entry_t>> rnw_db_t;
 
 
+	/*
+		Custom airport data base layout:
+		arpt_cache_hdr_t
+		arpt_cache_arpt_t[n_arpts]
+		arpt_cache_sect_t[n_sects]
+		char[str_sz]  String table. Strings aren't null-terminated.
+
+		Custom runway data base layout:
+		arpt_cache_hdr_t
+		arpt_cache_grp_t[n_arpts]
+		arpt_cache_rnw_t[n_rnws]
+		char[str_sz]
+
+		Airports are stored in the order in which they appear in apt.dat. A data base
+		is rebuilt if its signature, version, source stamp or minimum runway length 
+		don't match. If only the source stamp doesn't match, the airports of the 
+		sections of apt.dat that haven't changed are copied from the old data bases.
+	*/
+
+	struct arpt_cache_hdr_t
+	{
+		char sign[ARPT_CACHE_SIGN_SZ];
+		uint32_t byte_order;
+		uint32_t pad;
+		double db_version;
+		// Stamp of apt.dat that the data base has been created from
+		uint64_t src_size;
+		int64_t src_mtime;
+		double min_rwy_length_m;
+		uint64_t n_arpts, n_sects, n_rnws;
+		uint64_t str_sz;
+	};
+
+	struct arpt_cache_str_t
+	{
+		uint32_t offset, len;
+	};
+
+	struct arpt_cache_arpt_t
+	{
+		arpt_cache_str_t icao;
+		uint32_t elevation_ft, transition_alt_ft, transition_level;
+		uint32_t pad;
+		double lat_rad, lon_rad;
+		double nv_x, nv_y, nv_z;
+	};
+
+	struct arpt_cache_grp_t
+	// Runways of 1 airport. Runways of group i follow the runways of group i-1.
+	{
+		arpt_cache_str_t icao;
+		uint32_t n_rnws;
+		uint32_t pad;
+	};
+
+	struct arpt_cache_rnw_t
+	{
+		arpt_cache_str_t id;
+		int32_t displ_threshold_m;
+		uint32_t pad;
+		double start_lat_rad, start_lon_rad, end_lat_rad, end_lon_rad;
+		double start_nv_x, start_nv_y, start_nv_z;
+		double end_nv_x, end_nv_y, end_nv_z;
+	};
+
+	struct arpt_cache_sect_t
+	// Part of apt.dat that starts at an airport header which resets the parser, so it
+	// can be parsed on its own. Usually contains 1 airport.
+	{
+		uint64_t src_offset, src_len;
+		uint64_t hash;  // Hash of the text of the section
+		// Airports that have been added to the data base from this section
+		uint32_t arpt_idx, n_arpts;
+		// The last airport of the section has an icao code, so the next airport header
+		// with an elevation ends the section.
+		uint32_t has_icao;
+		uint32_t pad;
+	};
+
+
+	struct arpt_sect_t
+	{
+		const char* beg = nullptr;
+		size_t len = 0;
+		uint64_t hash = 0;
+		size_t arpt_idx = 0, n_arpts = 0;  // Index of the first airport in the shard
+		bool has_icao = false;
+	};
+
+	struct arpt_shard_t
+	// Airports parsed by 1 loader thread from a chunk of apt.dat
+	{
+		std::vector<airport_t> arpts;
+		std::vector<rnw_data_t> rnws;  // Runways of arpts[i] are in rnws[i]
+		std::vector<runway_data> rnw_maps;  // Same runways, keyed by id
+		std::vector<arpt_sect_t> sects;
+		bool is_last = false;  // The chunk contains the terminating line of the file
+	};
+
+	struct arpt_cache_view_t
+	// Old custom data bases, from which the sections that haven't changed are copied
+	{
+		const char* arpts = nullptr;  // arpt_cache_arpt_t[n_arpts]
+		const char* grps = nullptr;  // arpt_cache_grp_t[n_arpts]
+		const char* rnws = nullptr;  // arpt_cache_rnw_t[n_rnws]
+		const char* arpt_str_tbl = nullptr;
+		const char* rnw_str_tbl = nullptr;
+		uint64_t arpt_str_sz = 0, rnw_str_sz = 0;
+		uint64_t n_arpts = 0, n_rnws = 0;
+		std::vector<uint64_t> rnw_beg;  // Index of the first runway of each airport
+		std::vector<arpt_cache_sect_t> sects;  // In file order
+		std::unordered_map<uint64_t, size_t> sect_idx;  // Indices of sections by hash
+	};
+
+
 	class ArptDB
 	{
 		typedef std::pair<std::string, airport_data_t> str_arpt_data_t;
@@ -117,8 +324,16 @@ namespace libnav
 	public:
 		DbErr err_code;
 
+		/*
+			n_load_thr is the number of threads that parse apt.dat. The file is split 
+			into n_load_thr chunks at airport headers. The chunks are parsed into 
+			thread-local shards, which are merged in file order. 
+			0 means that std::thread::hardware_concurrency() threads will be used.
+		*/
+
 		ArptDB(std::string sim_arpt_path, std::string custom_arpt_path,
-			std::string custom_rnw_path, double min_rwy_l_m = MIN_RWY_LENGTH_M);
+			std::string custom_rnw_path, double min_rwy_l_m = MIN_RWY_LENGTH_M, 
+			size_t n_load_thr=1);
 
 		DbErr get_err();
 
@@ -128,45 +343,68 @@ namespace libnav
 
 		//These functions need to be public because they're used in 
 		//other threads when ArptDB object is constructed.
+		//They return 1 on success and 0 otherwise.
 
 		int load_from_sim_db();
 
-		void write_to_arpt_db();
+		// Same as load_from_sim_db, but the airports of the sections of apt.dat that 
+		// haven't changed are copied from the custom data bases
+		int update_from_sim_db();
+
+		int write_to_arpt_db();
 
-		void write_to_rnw_db();
+		int write_to_rnw_db();
 
-		void load_from_custom_arpt(); // Load data from custom airport database
+		int load_from_custom_arpt(); // Load data from custom airport database
 
-		void load_from_custom_rnw(); // Load data from custom runway database
+		int load_from_custom_rnw(); // Load data from custom runway database
 
 		// Normal user interface functions:
 
-		bool is_airport(std::string icao_code);
+		bool is_airport(const std::string& icao_code);
+
+		bool get_airport_data(const std::string& icao_code, airport_data_t* out);
+
+		int get_apt_rwys(const std::string& icao_code, runway_data* out);
+
+		int get_rnw_data(const std::string& apt_icao, const std::string& rnw_id, 
+			runway_entry_t* out);
 
-		bool get_airport_data(std::string icao_code, airport_data_t* out);
+		// The following functions return pointers into the data base instead of
+		// copying the data. They return nullptr if nothing was found. The pointers 
+		// are valid once get_err has returned.
 
-		int get_apt_rwys(std::string icao_code, runway_data* out);
+		const airport_data_t* find_airport(const std::string& icao_code);
 
-		int get_rnw_data(std::string apt_icao, std::string rnw_id, runway_entry_t* out);
+		const runway_data* find_apt_rwys(const std::string& icao_code);
 
 	private:
 		int db_version;  // May be used later
 		double min_rwy_length_m;
+		size_t n_load_threads;
+		bool has_src_stamp;
+		file_stamp_t src_stamp;  // Stamp of apt.dat
 
 		std::string custom_arpt_db_sign = "ARPTDB";
 		std::string custom_rnw_db_sign = "RNWDB";
 		bool apt_db_created = false;
 		bool rnw_db_created = false;
 
-		// Data for creating a custom airport database
+		// Data for creating a custom airport database. load_from_sim_db adds batches
+		// of airports to the queues. The writer threads sleep until there is a batch
+		// or until the queues are closed.
 
-		std::atomic<bool> write_arpt_db{ false };
+		bool queues_closed = false;
 
 		std::vector<airport_t> arpt_queue;
 		std::vector<rnw_data_t> rnw_queue;
+		// Sections of apt.dat. Set by the loader before the queues are closed.
+		std::vector<arpt_cache_sect_t> arpt_sects;
 
 		std::mutex arpt_queue_mutex;
 		std::mutex rnw_queue_mutex;
+		std::condition_variable arpt_queue_cv;
+		std::condition_variable rnw_queue_cv;
 
 		std::mutex arpt_db_mutex;
 		std::mutex rnw_db_mutex;
@@ -176,20 +414,88 @@ namespace libnav
 		std::string custom_rnw_db_path;
 
 		std::future<int> sim_db_loaded;
-		std::future<void> arpt_db_task;
-		std::future<void> rnw_db_task;
+		std::future<int> arpt_db_task;
+		std::future<int> rnw_db_task;
 
 		airport_db_t arpt_db;
 		rnw_db_t rnw_db;
 
-		static bool does_db_exist(std::string path, std::string sign);
+		// Returns true if the custom data base exists and can be used with apt.dat.
+		// arpt_rec_sz is the size of the records in the airport section.
+		bool does_db_exist(std::string path, std::string sign, size_t arpt_rec_sz);
+
+		arpt_cache_hdr_t get_cache_hdr(std::string& sign);
+
+		// Validates the header of a custom data base and the sizes of its sections.
+		// If check_src is false, the source stamp isn't checked.
+		bool read_cache_hdr(MappedFile& file, std::string& sign, size_t arpt_rec_sz, 
+			bool check_src, arpt_cache_hdr_t* out);
+
+		// Maps the old custom data bases and calls parse_sim_db with them if they can
+		// be used. The data bases are unmapped on return.
+		int parse_with_old_dbs();
+
+		// Parses apt.dat. If old isn't nullptr, unchanged sections are copied from it.
+		// The caller closes the queues.
+		int parse_sim_db(const arpt_cache_view_t* old);
 
 		static int get_db_version(std::string& line);
 
-		double parse_runway(std::string line, std::vector<runway_t>* rnw); // Returns runway length in meters
+		// Returns runway length in meters or 0 if the line is malformed
+		static double parse_runway(const char* line, size_t len, std::vector<runway_t>* rnw);
+
+		// If flush is true, the last airport of the chunk is added to the shard even
+		// though the terminating line hasn't been reached.
+		static void load_arpt_chunk(const char* beg, const char* end, bool flush, 
+			double min_rwy_l_m, arpt_shard_t* out);
+
+		// Splits the chunk into sections. Sections that are found in old are copied 
+		// from it, the rest are parsed.
+		static void update_arpt_chunk(const char* beg, const char* end, bool flush, 
+			double min_rwy_l_m, const arpt_cache_view_t* old, arpt_shard_t* out);
+
+		// Returns true if section idx of old starts at beg and hasn't changed
+		static bool is_same_sect(const arpt_cache_view_t& old, size_t idx, 
+			const char* beg, const char* end, bool flush);
+
+		// Copies the airports of section idx of old to the shard. beg is the beginning
+		// of the section in apt.dat. Returns false if old is damaged.
+		static bool copy_cache_sect(const arpt_cache_view_t& old, size_t idx, 
+			const char* beg, arpt_shard_t* out);
+
+		static void add_sect(const char* beg, const char* end, bool flush, 
+			size_t arpt_idx, bool has_icao, arpt_shard_t* out);
+
+		// Adds the airport to the shard if it passes the filters
+		static void add_to_shard(airport_t& arpt, rnw_data_t& rnw, double max_rnw_length_m, 
+			double min_rwy_l_m, arpt_shard_t* out);
+
+		// The following functions move the contents of the batch to the queue
+
+		static arpt_cache_str_t add_cache_str(std::string& str_tbl, const std::string& s);
+
+		static bool get_cache_str(const char* str_tbl, uint64_t str_sz, 
+			arpt_cache_str_t s, std::string* out);
+
+		static bool read_cache_arpt(const char* rec, const char* str_tbl, uint64_t str_sz, 
+			airport_t* out);
+
+		static bool read_cache_rnw(const char* rec, const char* str_tbl, uint64_t str_sz, 
+			runway_t* out);
+
+		void add_to_arpt_queue(std::vector<airport_t>& batch);
+
+		void add_to_rnw_queue(std::vector<rnw_data_t>& batch);
+
+		// Wakes the writer threads up once nothing else is going to be added
+
+		void close_queues();
+
+		// The following functions wait until the queue isn't empty and swap its contents
+		// with batch. They return false if the queue has been closed and is empty.
 
-		void add_to_arpt_queue(airport_t arpt);
+		bool get_arpt_batch(std::vector<airport_t>* batch);
 
-		void add_to_rnw_queue(rnw_data_t rnw);
+		bool get_rnw_batch(std::vector<rnw_data_t>* batch);
 	};
 } // namespace libnav
@@ -103,7 +103,18 @@ namespace libnav
 
         const awy_db_t& get_db();
 
-        bool is_in_awy(std::string awy, std::string point);
+        bool is_in_awy(const std::string& awy, const std::string& point);
+
+        /*
+            Function: find_awy
+            Description:
+            Gets the graph of an airway without copying it.
+            @param awy: airway name
+            @return: pointer to the graph or nullptr if there is no such airway. 
+            The pointer is valid once get_err has returned.
+        */
+
+        const graph_t* find_awy(const std::string& awy);
 
         /*
             Fucntion: get_ww_path
@@ -116,8 +127,8 @@ namespace libnav
             @return size of out
         */
 
-        size_t get_ww_path(std::string awy, std::string start, 
-            std::string end, std::vector<awy_point_t>* out);
+        size_t get_ww_path(const std::string& awy, const std::string& start, 
+            const std::string& end, std::vector<awy_point_t>* out);
 
         /*
             Fucntion: get_aa_path
@@ -131,8 +142,8 @@ namespace libnav
             @return size of out
         */
 
-        size_t get_aa_path(std::string awy, std::string start, 
-            std::string next_awy, std::vector<awy_point_t>* out);
+        size_t get_aa_path(const std::string& awy, const std::string& start, 
+            const std::string& next_awy, std::vector<awy_point_t>* out);
 
         /*
             Fucntion: get_path
@@ -147,7 +158,7 @@ namespace libnav
             @return size of out
         */
 
-        size_t get_path(std::string awy, std::string start, 
+        size_t get_path(const std::string& awy, const std::string& start, 
             std::vector<awy_point_t>* out, awy_path_func_t path_func, void* ref);
 
         // You aren't supposed to call this function.
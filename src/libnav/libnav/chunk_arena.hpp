@@ -0,0 +1,119 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains ChunkArena class template. ChunkArena is an append-only 
+	container that allocates its storage in fixed size chunks. Unlike std::vector,
+	growing it never moves the existing items, so pointers to them stay valid 
+	until the arena is cleared or destroyed.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+
+namespace libnav
+{
+	template <class T>
+	class ChunkArena
+	{
+	public:
+		ChunkArena(size_t chunk_size)
+		{
+			chunk_sz = chunk_size;
+			if(chunk_sz == 0)
+			{
+				chunk_sz = 1;
+			}
+			n_items = 0;
+		}
+
+		ChunkArena(const ChunkArena&) = delete;
+
+		ChunkArena& operator=(const ChunkArena&) = delete;
+
+		/*
+			Function: add
+			Description:
+			Appends a copy of an item. A new chunk is allocated if the last one is full.
+			@param item: item to add
+			@return: pointer to the stored item. It stays valid until clear is called.
+		*/
+
+		T* add(const T& item)
+		{
+			if(n_items == chunks.size() * chunk_sz)
+			{
+				chunks.push_back(std::unique_ptr<T[]>(new T[chunk_sz]));
+			}
+			T* out = &chunks.back()[n_items % chunk_sz];
+			*out = item;
+			n_items++;
+
+			return out;
+		}
+
+		size_t size() const
+		{
+			return n_items;
+		}
+
+		T& operator[](size_t idx)
+		{
+			return chunks[idx / chunk_sz][idx % chunk_sz];
+		}
+
+		const T& operator[](size_t idx) const
+		{
+			return chunks[idx / chunk_sz][idx % chunk_sz];
+		}
+
+		/*
+			Function: get_idx
+			Description:
+			Finds index of an item given a pointer returned by add.
+			@param ptr: pointer to the item
+			@return: index of the item or size() if ptr doesn't point into the arena.
+		*/
+
+		size_t get_idx(const T* ptr) const
+		{
+			std::less<const T*> less;
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				const T* beg = chunks[i].get();
+				if(!less(ptr, beg) && less(ptr, beg + chunk_sz))
+				{
+					size_t idx = i * chunk_sz + size_t(ptr - beg);
+					if(idx < n_items)
+					{
+						return idx;
+					}
+					break;
+				}
+			}
+			return n_items;
+		}
+
+		// Frees all chunks. All pointers to the items become invalid.
+		void clear()
+		{
+			chunks.clear();
+			n_items = 0;
+		}
+
+	private:
+		size_t chunk_sz;
+		size_t n_items;
+		std::vector<std::unique_ptr<T[]>> chunks;
+	};
+}; // namespace libnav
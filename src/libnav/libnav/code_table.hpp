@@ -0,0 +1,113 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of functions for the global code table. The table 
+	interns short strings such as area and country codes, so that data base entries 
+	can store them as integer ids. Ids are never released and stay valid for the 
+	lifetime of the process.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "str_utils.hpp"
+
+
+namespace libnav
+{
+	typedef uint32_t code_id_t;
+
+	constexpr code_id_t CODE_ID_EMPTY = 0;  // Id of an empty string
+	constexpr size_t CODE_TABLE_CHUNK_SZ = 4096;
+	constexpr size_t CODE_TABLE_N_CHUNKS = 4096;
+
+
+	/*
+		Function: intern_code
+		Description:
+		Returns id of a string. The string is added to the table if it isn't there yet.
+		This function is thread safe.
+		@param s: pointer to the string. It doesn't have to be null-terminated.
+		@param len: length of the string
+		@return: id of the string or CODE_ID_EMPTY if the table is full.
+	*/
+
+	code_id_t intern_code(const char* s, size_t len);
+
+	code_id_t intern_code(const std::string& s);
+
+	/*
+		Function: find_code
+		Description:
+		Looks up id of a string without adding it to the table.
+		@param s: string
+		@param out: pointer to the output id
+		@return: true if the string is in the table, false otherwise.
+	*/
+
+	bool find_code(const std::string& s, code_id_t* out);
+
+	/*
+		Function: get_code_str
+		Description:
+		Returns the string an id was given to. This function doesn't lock.
+		@param id: id returned by intern_code
+		@return: reference to the string. Unknown ids map to an empty string.
+	*/
+
+	const std::string& get_code_str(code_id_t id);
+
+
+	class LocalCodeTable
+	// Interns codes for 1 loader thread without locking. Ids are only valid within
+	// the table until they are converted with get_global_ids. Like in the global 
+	// table, 0 is the id of an empty string.
+	{
+	public:
+		LocalCodeTable();
+
+		LocalCodeTable(const LocalCodeTable&) = delete;
+
+		LocalCodeTable& operator=(const LocalCodeTable&) = delete;
+
+		// Doesn't allocate memory if the string is already in the table
+		code_id_t intern(const char* s, size_t len);
+
+		/*
+			Function: get_global_ids
+			Description:
+			Adds all strings of the table to the global table.
+			@return: vector of global ids. Item i is the global id of local id i.
+		*/
+
+		std::vector<code_id_t> get_global_ids() const;
+
+	private:
+		struct view_hash_t
+		{
+			size_t operator()(const strutils::str_view_t& s) const;
+		};
+
+		struct view_eq_t
+		{
+			bool operator()(const strutils::str_view_t& a, 
+				const strutils::str_view_t& b) const;
+		};
+
+		// Elements of a deque aren't moved when it grows, so the keys of ids stay valid
+		std::deque<std::string> codes;
+		std::unordered_map<strutils::str_view_t, code_id_t, view_hash_t, 
+			view_eq_t> ids;
+	};
+}; // namespace libnav
@@ -0,0 +1,132 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of member functions for CoverageGrid class.
+	CoverageGrid precomputes which navaids may be received in every lat/lon cell
+	and altitude band, using their reception ranges, elevations and the
+	VOR_MAX_SLANT_ANGLE_DEG limit. A query is then a cell lookup followed by an
+	exact check of the listed stations. Once built, the grid is read-only, so any
+	number of receivers can query it from different threads.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "navaid_db.hpp"
+#include "geo_grid.hpp"
+
+
+namespace radnav_util
+{
+	// Cell size. Should divide 180.
+	constexpr double COV_GRID_CELL_DEG = 1;
+	constexpr double COV_GRID_BAND_FT = 5000;
+	// Number of altitude bands. The last band has no upper limit. At most 32.
+	constexpr size_t COV_GRID_N_BANDS = 10;
+	constexpr size_t COV_GRID_MAX_BANDS = 32;
+
+
+	struct coverage_res_t
+	{
+		size_t idx;  // Index of the station. See CoverageGrid::get_station
+		double qual;  // See get_navaid_qual
+	};
+
+
+	class CoverageGrid
+	{
+	public:
+		/*
+			Function: CoverageGrid
+			Description:
+			@param db: navaid data base
+			@param type: type mask of the stations to include
+			@param cell_deg: size of the cells in degrees. Should divide 180.
+			@param band_ft: height of the altitude bands
+			@param n_bands: number of altitude bands
+		*/
+
+		CoverageGrid(std::shared_ptr<libnav::NavaidDB> db,
+			libnav::NavaidType type=libnav::NavaidType::NAVAID,
+			double cell_deg=COV_GRID_CELL_DEG, double band_ft=COV_GRID_BAND_FT,
+			size_t n_bands=COV_GRID_N_BANDS);
+
+		/*
+			Function: build
+			Description:
+			Builds the grid. Previous contents are discarded. Must not be called while
+			the grid is being queried.
+			@return: false if the data base hasn't been loaded yet.
+		*/
+
+		bool build();
+
+		bool is_built();
+
+		size_t get_n_stations();
+
+		const navaid_t& get_station(size_t idx);
+
+		/*
+			Function: get_candidates
+			Description:
+			Gets the stations that may be receivable at a position. This is a superset
+			of the receivable stations.
+			@param ac_pos: position of the aircraft
+			@param out: pointer to the output vector. It is cleared first. Station
+			indices are written to it.
+			@return: number of items written to out.
+		*/
+
+		size_t get_candidates(geo::point3d ac_pos, std::vector<size_t>* out);
+
+		/*
+			Function: get_receivable
+			Description:
+			Gets the stations that are receivable at a position. The candidates of the
+			cell are checked with get_navaid_qual.
+			@param ac_pos: position of the aircraft
+			@param out: pointer to the output vector. It is cleared first. Results are
+			written in no particular order.
+			@return: number of items written to out.
+		*/
+
+		size_t get_receivable(geo::point3d ac_pos, std::vector<coverage_res_t>* out);
+
+	private:
+		struct cell_item_t
+		{
+			uint32_t stn_idx;
+			uint32_t band_mask;  // Bit i is set if the station may be received in band i
+		};
+
+		std::shared_ptr<libnav::NavaidDB> navaid_db;
+		libnav::NavaidType stn_type;
+		double cell_rad, band_height_ft;
+		size_t n_bands_total, n_lat, n_lon;
+		bool is_grid_built;
+
+		std::vector<navaid_t> stations;
+		// Items of cell i are items[cell_beg[i]] to items[cell_beg[i+1]-1]
+		std::vector<uint32_t> cell_beg;
+		std::vector<cell_item_t> items;
+
+
+		size_t get_cell(geo::point p);
+
+		size_t get_band(double alt_ft);
+
+		// Returns a mask of the bands in which a station may be received anywhere
+		// within a cell. The distance from the station to the cell is between
+		// d_min_nm and d_max_nm.
+		uint32_t get_band_mask(const navaid_t& stn, double d_min_nm, double d_max_nm);
+	};
+}; // namespace radnav_util
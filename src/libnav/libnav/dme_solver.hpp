@@ -0,0 +1,125 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of member functions for DmeSolver class. DmeSolver
+	calculates a least-squares position fix from any number of DME ranges. Unlike
+	geo::get_dme_dme_pos, it returns a single position and its covariance. Each fix
+	is used as the starting point of the next one, so that a few iterations are
+	enough when the solver is called periodically.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "geo_utils.hpp"
+
+
+namespace radnav_util
+{
+	constexpr size_t DME_SOLVER_MAX_ITER = 10;
+	// The solution is accepted once a step gets shorter than this
+	constexpr double DME_SOLVER_TOL_NM = 0.0001;
+	// Fixes are rejected as degenerate(e.g. all DMEs on one line with the aircraft)
+	// if det(normal matrix) < DME_SOLVER_MIN_DET_RATIO * trace(normal matrix)^2.
+	constexpr double DME_SOLVER_MIN_DET_RATIO = 1e-6;
+
+
+	struct dme_meas_t
+	{
+		geo::point pos;  // Position of the DME
+		double elev_ft;  // Elevation of the DME AMSL
+		double dist_nm;  // Measured slant range
+	};
+
+	struct dme_vec_t
+	// Earth-centered cartesian coordinates, nm. The Earth is a sphere with radius
+	// geo::EARTH_RADIUS_NM like in geo::point::get_line_dist_nm.
+	{
+		double x, y, z;
+	};
+
+	struct dme_fix_t
+	{
+		geo::point pos;
+		// Covariance of the position in a local frame, nm^2
+		double cov_ee, cov_en, cov_nn;
+		// 2 * drms, nm. Uses the DO-236C DME error model as measurement noise.
+		double fom_nm;
+		// Root mean square of the range residuals, nm
+		double rms_res_nm;
+		size_t n_iter;
+	};
+
+
+	class DmeSolver
+	{
+	public:
+		/*
+			Function: DmeSolver
+			Description:
+			@param max_iter: maximum number of Gauss-Newton iterations per fix
+			@param tol_nm: a fix is accepted once a step gets shorter than this
+		*/
+
+		DmeSolver(size_t max_iter=DME_SOLVER_MAX_ITER, double tol_nm=DME_SOLVER_TOL_NM);
+
+		/*
+			Function: reset
+			Description:
+			Forgets the last fix. The next fix will start from scratch.
+		*/
+
+		void reset();
+
+		/*
+			Function: set_guess
+			Description:
+			Sets the starting point of the next fix, e.g. the FMS position.
+			@param pos: estimated aircraft position
+		*/
+
+		void set_guess(geo::point pos);
+
+		/*
+			Function: solve
+			Description:
+			Calculates a position fix. Without a starting point, the fix starts from
+			the solution of geo::get_dme_dme_pos for the first 2 DMEs that fits all
+			of the ranges best. With only 2 DMEs that is ambiguous, so set_guess should
+			be called first. Doesn't allocate memory once the solver has seen the
+			largest number of measurements.
+			@param meas: DME measurements. At least 2 are needed.
+			@param ac_alt_ft: altitude of the aircraft AMSL
+			@param out: pointer to the output fix
+			@return: true if a fix has been found. On failure, the last fix is kept.
+		*/
+
+		bool solve(const std::vector<dme_meas_t>& meas, double ac_alt_ft, dme_fix_t* out);
+
+	private:
+		size_t n_iter_max;
+		double tol;
+
+		bool has_guess;
+		geo::point guess;
+
+		// Positions and weights of the DMEs of the current fix. Kept between calls,
+		// so that their memory is reused.
+		std::vector<dme_vec_t> st_vec;
+		std::vector<double> weights;
+
+
+		bool get_start_pos(const std::vector<dme_meas_t>& meas, double ac_alt_ft,
+			geo::point* out);
+
+		static double get_rms_res(const std::vector<dme_meas_t>& meas, geo::point pos,
+			double ac_alt_ft);
+	};
+}; // namespace radnav_util
@@ -0,0 +1,52 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of batch versions of the FOM functions from
+	radnav_util. Each function processes whole arrays of distances, so that the FOMs
+	of many stations can be calculated with SIMD instructions. AVX is used when the
+	library is built with it(see LIBNAV_AVX2 option), SSE2 on other x86-64 builds.
+	Other targets use a plain loop. Results are equal to the scalar functions.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+
+
+namespace radnav_util
+{
+	/*
+		Function: get_dme_fom_batch
+		Description:
+		Batch version of get_dme_fom.
+		@param dist_nm: array of total distances to the stations
+		@param n: number of items in dist_nm
+		@param out: array where the FOMs will be written. Must hold n items.
+	*/
+
+	void get_dme_fom_batch(const double* dist_nm, size_t n, double* out);
+
+	void get_vor_fom_batch(const double* dist_nm, size_t n, double* out);
+
+	void get_vor_dme_fom_batch(const double* dist_nm, size_t n, double* out);
+
+	/*
+		Function: get_dme_dme_fom_batch
+		Description:
+		Batch version of get_dme_dme_fom. Item i of every array describes pair i.
+		@param dist1_nm: distances to the first DMEs
+		@param dist2_nm: distances to the second DMEs
+		@param phi_rad: encounter geometry angles
+		@param n: number of pairs
+		@param out: array where the FOMs will be written. Must hold n items.
+	*/
+
+	void get_dme_dme_fom_batch(const double* dist1_nm, const double* dist2_nm,
+		const double* phi_rad, size_t n, double* out);
+}; // namespace radnav_util
@@ -0,0 +1,99 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of batch versions of the great circle functions
+	of geo::point. Each function calculates distances or bearings from one reference
+	point to arrays of latitudes and longitudes. Trigonometric functions of the
+	reference point are calculated once per call and the rest is done with SIMD
+	instructions(see simd_utils.hpp). Results match the scalar functions to within
+	a few ulp. The only exception are bearings very close to 90 or 270 degrees, which
+	the scalar function may return as 0.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "geo_utils.hpp"
+
+
+namespace geo
+{
+	// Points stored as separate arrays of latitudes and longitudes
+	struct point_soa
+	{
+		std::vector<double> lat_rad, lon_rad;
+
+
+		void reserve(size_t n)
+		{
+			lat_rad.reserve(n);
+			lon_rad.reserve(n);
+		}
+
+		void push_back(point p)
+		{
+			lat_rad.push_back(p.lat_rad);
+			lon_rad.push_back(p.lon_rad);
+		}
+
+		void clear()
+		{
+			lat_rad.clear();
+			lon_rad.clear();
+		}
+
+		size_t size() const
+		{
+			return lat_rad.size();
+		}
+	};
+
+
+	/*
+		Function: get_ang_dist_rad_batch
+		Description:
+		Batch version of point::get_ang_dist_rad.
+		Param:
+		ref: reference point
+		lat_rad: array of latitudes
+		lon_rad: array of longitudes
+		n: number of points
+		out: array where the angular distances will be written. Must hold n items.
+	*/
+
+	void get_ang_dist_rad_batch(point ref, const double* lat_rad, const double* lon_rad,
+		size_t n, double* out);
+
+	// Batch version of point::get_gc_dist_nm. See get_ang_dist_rad_batch.
+	void get_gc_dist_nm_batch(point ref, const double* lat_rad, const double* lon_rad,
+		size_t n, double* out);
+
+	// Batch version of point::get_gc_bearing_rad. Calculates bearings from ref to
+	// the points. See get_ang_dist_rad_batch.
+	void get_gc_bearing_rad_batch(point ref, const double* lat_rad, const double* lon_rad,
+		size_t n, double* out);
+
+
+	inline void get_gc_dist_nm_batch(point ref, const point_soa& pts,
+		std::vector<double>* out)
+	{
+		out->resize(pts.size());
+		get_gc_dist_nm_batch(ref, pts.lat_rad.data(), pts.lon_rad.data(), pts.size(),
+			out->data());
+	}
+
+	inline void get_gc_bearing_rad_batch(point ref, const point_soa& pts,
+		std::vector<double>* out)
+	{
+		out->resize(pts.size());
+		get_gc_bearing_rad_batch(ref, pts.lat_rad.data(), pts.lon_rad.data(),
+			pts.size(), out->data());
+	}
+}; // namespace geo
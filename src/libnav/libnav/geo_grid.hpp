@@ -0,0 +1,112 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of member functions for GeoGrid class. GeoGrid is 
+	a static spatial index over points on Earth's surface. Points are bucketed into 
+	lat/lon cells that are stored contiguously, and every point is kept as a unit 
+	vector, so that distance checks don't need any trigonometry.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "geo_utils.hpp"
+
+
+namespace libnav
+{
+	constexpr size_t GEO_GRID_N_LAT = 180;
+	constexpr size_t GEO_GRID_N_LON = 360;
+	constexpr double GEO_GRID_CELL_RAD = M_PI / double(GEO_GRID_N_LAT);
+	constexpr double GEO_GRID_SEL_MARGIN_RAD = 1e-9;
+	// Initial search radius of get_k_nearest. It is multiplied by 
+	// GEO_GRID_KNN_RAD_MULT until enough items are found.
+	constexpr double GEO_GRID_KNN_START_NM = 20;
+	constexpr double GEO_GRID_KNN_RAD_MULT = 4;
+
+
+	struct geo_grid_res_t
+	{
+		size_t idx;  // Index of the item in the vector passed to build
+		double dist_nm;
+	};
+
+	typedef bool (*geo_grid_filter_t)(size_t, void*);
+
+
+	class GeoGrid
+	{
+	public:
+		GeoGrid();
+
+		/*
+			Function: build
+			Description:
+			Builds the index. Previous contents are discarded.
+			@param pts: positions of the items. Item i is located at pts[i].
+		*/
+
+		void build(const std::vector<geo::point>& pts);
+
+		size_t get_n_items();
+
+		/*
+			Function: get_in_radius
+			Description:
+			Finds all items within a great circle distance of a point.
+			@param p: center of the search
+			@param dist_nm: search radius
+			@param out: pointer to the output vector. Results are appended in no 
+			particular order.
+			@param filt_func: optional filter. Items are skipped if it returns false.
+			@param ref: pointer passed to filt_func
+			@return: number of items written to out.
+		*/
+
+		size_t get_in_radius(geo::point p, double dist_nm, 
+			std::vector<geo_grid_res_t>* out, geo_grid_filter_t filt_func=nullptr, 
+			void* ref=nullptr);
+
+		/*
+			Function: get_k_nearest
+			Description:
+			Finds k items nearest to a point.
+			@param p: center of the search
+			@param k: maximum number of items to find
+			@param out: pointer to the output vector. Results are appended in order of
+			increasing distance.
+			@param filt_func: optional filter. Items are skipped if it returns false.
+			@param ref: pointer passed to filt_func
+			@return: number of items written to out.
+		*/
+
+		size_t get_k_nearest(geo::point p, size_t k, std::vector<geo_grid_res_t>* out, 
+			geo_grid_filter_t filt_func=nullptr, void* ref=nullptr);
+
+	private:
+		struct item_t
+		{
+			geo::nvec pos;
+			size_t idx;
+		};
+
+		// Items of cell i are items[cell_beg[i]] to items[cell_beg[i+1]-1]
+		std::vector<uint32_t> cell_beg;
+		std::vector<item_t> items;
+
+
+		static size_t get_lat_row(double lat_rad);
+
+		static size_t get_lon_col(double lon_rad);
+
+		static item_t get_item(geo::point p, size_t idx);
+	};
+}; // namespace libnav
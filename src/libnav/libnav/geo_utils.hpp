@@ -53,6 +53,129 @@ namespace geo
 		return out;
 	}
 
+	struct point;
+
+	/*
+		Unit vector from the center of the Earth to a point on its surface(n-vector).
+		Positions that are compared often can store one, so that distance comparisons
+		are just dot products. Trigonometry is only needed for the final distance.
+		A zero vector means that the n-vector hasn't been calculated.
+	*/
+
+	struct nvec
+	{
+		double x = 0, y = 0, z = 0;
+
+
+		bool is_set() const
+		{
+			return x != 0 || y != 0 || z != 0;
+		}
+
+		// Cosine of the angular distance
+		double dot(nvec const& other) const
+		{
+			return x * other.x + y * other.y + z * other.z;
+		}
+
+		/*
+			Function: get_chord_sq
+			Description:
+			Function that calculates the squared length of a straight line segment between 2 
+			n-vectors. It grows monotonically with the great circle distance, so it can be 
+			used for comparisons.
+			Param:
+			other: second n-vector
+			Return:
+			Returns a value between 0 and 4.
+		*/
+
+		double get_chord_sq(nvec const& other) const
+		{
+			double dx = x - other.x;
+			double dy = y - other.y;
+			double dz = z - other.z;
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		// Same as point::get_ang_dist_rad
+		double get_ang_dist_rad(nvec const& other) const
+		{
+			double chord = sqrt(get_chord_sq(other));
+			if(chord > 2)
+			{
+				chord = 2;
+			}
+			return 2 * asin(chord / 2);
+		}
+
+		// Same as point::get_gc_dist_nm
+		double get_gc_dist_nm(nvec const& other) const
+		{
+			return get_ang_dist_rad(other) * EARTH_RADIUS_NM;
+		}
+
+		/*
+			Function: get_approx_dist_nm
+			Description:
+			Function that approximates the great circle distance by the length of the chord 
+			between 2 n-vectors. It only takes a square root. The approximation never 
+			exceeds the great circle distance d and is at most d^3 / (24 * EARTH_RADIUS_NM^2)
+			shorter(see get_approx_dist_err_nm). Thus, any point with an approximate distance 
+			above some limit can be rejected before the exact distance is calculated.
+			Param:
+			other: second n-vector
+			Return:
+			Returns a non-negative distance value.
+		*/
+
+		double get_approx_dist_nm(nvec const& other) const
+		{
+			return sqrt(get_chord_sq(other)) * EARTH_RADIUS_NM;
+		}
+
+		point get_point() const;
+	};
+
+	/*
+		Function: get_chord_sq
+		Description:
+		Function that converts a great circle distance to a value that can be compared to 
+		nvec::get_chord_sq.
+		Param:
+		dist_nm: great circle distance
+		Return:
+		Returns a value between 0 and 4.
+	*/
+
+	inline double get_chord_sq(double dist_nm)
+	{
+		double ang_rad = dist_nm / EARTH_RADIUS_NM;
+		if(ang_rad > M_PI)
+		{
+			ang_rad = M_PI;
+		}
+		double chord = 2 * sin(ang_rad / 2);
+		return chord * chord;
+	}
+
+	/*
+		Function: get_approx_dist_err_nm
+		Description:
+		Function that calculates the worst-case error of nvec::get_approx_dist_nm, e.g. 
+		0.004 nm at 100 nm, 0.1 nm at 300 nm and 3.5 nm at 1000 nm.
+		Param:
+		dist_nm: great circle distance
+		Return:
+		Returns the maximum difference between the great circle distance and its 
+		approximation.
+	*/
+
+	inline double get_approx_dist_err_nm(double dist_nm)
+	{
+		return dist_nm * dist_nm * dist_nm / (24 * EARTH_RADIUS_NM * EARTH_RADIUS_NM);
+	}
+
 	struct point
 	{
 		double lat_rad, lon_rad;
@@ -63,6 +186,16 @@ namespace geo
 			return lat_rad == other.lat_rad && lon_rad == other.lon_rad;
 		}
 
+		nvec get_nvec() const
+		{
+			double cos_lat = cos(lat_rad);
+			nvec out;
+			out.x = cos_lat * cos(lon_rad);
+			out.y = cos_lat * sin(lon_rad);
+			out.z = sin(lat_rad);
+			return out;
+		}
+
 		/*
 			Function: get_gc_bearing_rad
 			Description:
@@ -154,6 +287,16 @@ namespace geo
 		}
 	};
 
+	inline point nvec::get_point() const
+	{
+		double z_clamped = z;
+		if(z_clamped > 1)
+			z_clamped = 1;
+		if(z_clamped < -1)
+			z_clamped = -1;
+		return {asin(z_clamped), atan2(y, x)};
+	}
+
 	/*
 		Function: get_pos_from_brng_dist
 		Description:
@@ -293,7 +436,7 @@ namespace geo
 
 		// Step 0: Convert slant-ranges to angular distance
 		double a_u = (d_u_nm - ac_alt_nm + elev_1_nm) * (d_u_nm + ac_alt_nm - elev_1_nm);
-		double a_s = (d_s_nm - ac_alt_nm + elev_1_nm) * (d_s_nm + ac_alt_nm - elev_1_nm);
+		double a_s = (d_s_nm - ac_alt_nm + elev_2_nm) * (d_s_nm + ac_alt_nm - elev_2_nm);
 		double b_u = (EARTH_RADIUS_NM + elev_1_nm) * (EARTH_RADIUS_NM + ac_alt_nm);
 		double b_s = (EARTH_RADIUS_NM + elev_2_nm) * (EARTH_RADIUS_NM + ac_alt_nm);
 		double theta_ua = 2 * asin(0.5 * (sqrt(a_u / b_u)));
@@ -301,7 +444,7 @@ namespace geo
 		// Step 1: Solve the spherical triangle for each station
 		double sin_lat = std::pow(sin(0.5 * lat_diff), 2);
 		double sin_lon = std::pow(sin(0.5 * lon_diff), 2);
-		double theta_us = 2 * asin(sqrt(sin_lat + a * sin_lon));
+		double theta_us = 2 * asin(sqrt(sin_lat + cos(lat_u_rad) * cos(lat_s_rad) * sin_lon));
 		double psi_su = atan2((cos(lat_s_rad) * sin(lon_diff)), (b - a * cos(lon_diff)));
 		// Step 2: Confirm inputs are consistent and a solution exists
 		if (theta_ua + theta_sa >= theta_us && abs(theta_ua - theta_sa) <= theta_us)
@@ -70,9 +70,20 @@ namespace libnav
 
         const hold_db_t& get_db();
 
-        bool has_hold(std::string& wpt_id);
+        bool has_hold(const std::string& wpt_id);
 
-        std::vector<hold_data_t> get_hold_data(std::string& wpt_id);
+        std::vector<hold_data_t> get_hold_data(const std::string& wpt_id);
+
+        /*
+            Function: find_hold_data
+            Description:
+            Gets all holds of a waypoint without copying them.
+            @param wpt_id: id of the waypoint(hold data base id)
+            @return: pointer to the holds or nullptr if there are none. The pointer is
+            valid once get_err has returned.
+        */
+
+        const std::vector<hold_data_t>* find_hold_data(const std::string& wpt_id);
 
         // You don't need to call this one.
         // It's called by the corresponding thread that is created in the constructor.
@@ -0,0 +1,81 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of member functions for MappedFile class. MappedFile
+	maps a whole file into memory in read-only mode, so that the data base loaders can
+	tokenize it in place without copying every line into a std::string. The file also
+	declares get_file_stamp, which is used to tell if a file has changed.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace libnav
+{
+	struct file_stamp_t
+	// Size and modification time of a file
+	{
+		uint64_t size;
+		int64_t mtime;  // Units depend on the platform
+	};
+
+
+	/*
+		Function: get_file_stamp
+		Description:
+		Gets the size and the modification time of a file without opening it.
+		@param path: path to the file
+		@param out: pointer to the output stamp
+		@return: false if the file doesn't exist.
+	*/
+
+	bool get_file_stamp(std::string path, file_stamp_t* out);
+
+
+	class MappedFile
+	{
+	public:
+		MappedFile(std::string path);
+
+		MappedFile(const MappedFile&) = delete;
+
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/*
+			Function: is_open
+			Description:
+			@return: true if the file has been mapped successfully. Empty files are
+			considered open, but their data pointer is nullptr.
+		*/
+
+		bool is_open();
+
+		const char* data();
+
+		size_t size();
+
+		~MappedFile();
+
+	private:
+		bool f_open;
+		const char* map_ptr;
+		size_t map_sz;
+
+#ifdef _WIN32
+		void* file_handle;
+		void* map_handle;
+#else
+		int fd;
+#endif
+	};
+}; // namespace libnav
@@ -15,6 +15,8 @@
 
 #include <fstream>
 #include <future>
+#include <atomic>
+#include <thread>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -25,6 +27,10 @@
 #include "geo_utils.hpp"
 #include "common.hpp"
 #include "str_utils.hpp"
+#include "mmap_file.hpp"
+#include "code_table.hpp"
+#include "geo_grid.hpp"
+#include "chunk_arena.hpp"
 
 
 namespace libnav
@@ -36,7 +42,17 @@ namespace libnav
 	constexpr double DME_DME_PHI_MIN_DEG = 30;
 	constexpr double DME_DME_PHI_MAX_DEG = 180 - DME_DME_PHI_MIN_DEG;
 	constexpr double MAX_ANG_DEV_MERGE = 0.0006;
-	constexpr size_t NAVAID_ENTRY_CACHE_SZ = 300000;
+	// Cell size of the colocated navaid index. Navaids closer than MAX_ANG_DEV_MERGE
+	// always end up in neighboring cells.
+	constexpr double NAVAID_MERGE_CELL_RAD = 2 * MAX_ANG_DEV_MERGE;
+	constexpr size_t NAVAID_ENTRY_CHUNK_SZ = 4096;
+	// Snapshot file constants:
+	constexpr char NAVAID_SNAP_MAGIC[] = "LNAVSNP";
+	constexpr size_t NAVAID_SNAP_MAGIC_SZ = sizeof(NAVAID_SNAP_MAGIC);
+	constexpr uint32_t NAVAID_SNAP_VERSION = 2;
+	// Used to reject snapshots written on a host with different byte order
+	constexpr uint32_t NAVAID_SNAP_BYTE_ORDER = 0x01020304;
+	constexpr uint64_t NAVAID_SNAP_NO_NAVAID = UINT64_MAX;
 
 
 	enum XPLM_navaid_types
@@ -79,11 +95,36 @@ namespace libnav
 		NavaidType type;
 		uint32_t arinc_type = 0;  // Ref: arinc424 spec, section 5.42
 		geo::point pos;
-		std::string area_code;
-		std::string country_code;
+		// Interned codes. Use get_code_str to get the strings.
+		code_id_t area_code = CODE_ID_EMPTY;
+		code_id_t country_code = CODE_ID_EMPTY;
+		// Offset of the description in the description pool of the data base.
+		// Use NavaidDB::get_fix_desc to get the string. 0 means no description.
+		uint32_t desc_offset = 0;
 		navaid_entry_t* navaid = nullptr;
+#ifdef LIBNAV_STORE_NVEC
+		// Calculated once by NavaidDB while loading. Use get_nvec to access it.
+		geo::nvec pos_nv = {};
+#endif
 		
 
+		geo::nvec get_nvec() const
+		{
+#ifdef LIBNAV_STORE_NVEC
+			if(pos_nv.is_set())
+				return pos_nv;
+#endif
+			return pos.get_nvec();
+		}
+
+		// Stores the n-vector of pos. Does nothing unless LIBNAV_STORE_NVEC is defined.
+		void store_nvec()
+		{
+#ifdef LIBNAV_STORE_NVEC
+			pos_nv = pos.get_nvec();
+#endif
+		}
+
 		bool cmp(waypoint_entry_t const& other);
 
 		bool operator==(waypoint_entry_t const& other);
@@ -123,18 +164,25 @@ namespace libnav
 
 	
 	typedef bool (*navaid_filter_t)(waypoint_t, void*);
+	// Visitors get references into the data base. Returning false stops the visit.
+	typedef bool (*wpt_visitor_t)(const std::string&, const waypoint_entry_t&, void*);
 
 	bool default_navaid_filter(waypoint_t in, void* ref);
 
 
 	struct wpt_line_t
-	// This is used to store the contents of 1 line of earth_nav.dat
+	// This is used to store the contents of 1 line of earth_fix.dat
     {
         earth_data_line_t data;
 
 		waypoint_t wpt;
-        std::string desc;
+        strutils::str_view_t desc;  // Points into the parsed line
+
 
+		// Parses a line in place. s doesn't have to be null-terminated. Codes are
+		// interned in codes or in the global table if codes is nullptr.
+		wpt_line_t(const char* s, size_t len, int db_version, 
+			LocalCodeTable* codes=nullptr);
 
         wpt_line_t(std::string& s, int db_version);
     };
@@ -146,9 +194,13 @@ namespace libnav
 
 		waypoint_t wpt;
 		navaid_entry_t navaid;
-        std::string desc;  // Spoken name of the navaid
+        strutils::str_view_t desc;  // Spoken name of the navaid. Points into the parsed line
 
 
+		// Parses a line in place. s doesn't have to be null-terminated. Codes are
+		// interned in codes or in the global table if codes is nullptr.
+		navaid_line_t(const char* s, size_t len, LocalCodeTable* codes=nullptr);
+
         navaid_line_t(std::string& s);
     };
 
@@ -157,14 +209,14 @@ namespace libnav
 	{
 	public:
 		geo::point ac_pos; // Aircraft position
-		bool operator()(waypoint_entry_t w1, waypoint_entry_t w2);
+		bool operator()(const waypoint_entry_t& w1, const waypoint_entry_t& w2);
 	};
 
 	class WaypointCompare
 	{
 	public:
 		geo::point ac_pos; // Aircraft position
-		bool operator()(waypoint_t w1, waypoint_t w2);
+		bool operator()(const waypoint_t& w1, const waypoint_t& w2);
 	};
 
 
@@ -172,6 +224,91 @@ namespace libnav
 			std::vector<libnav::waypoint_entry_t>> wpt_db_t;
 
 
+	struct wpt_shard_t
+	// Waypoints parsed by 1 loader thread from a chunk of earth_fix.dat
+	{
+		wpt_db_t wpts;
+		std::string desc_pool = std::string(1, '\0');  // Descriptions of wpts
+		LocalCodeTable codes;  // Area and country codes of wpts
+		bool is_last = false;  // The chunk contains the terminating line of the file
+		bool is_partial = false;  // The chunk contains lines that couldn't be parsed
+	};
+
+	struct navaid_shard_t
+	// Lines parsed by 1 loader thread from a chunk of earth_nav.dat
+	{
+		std::vector<navaid_line_t> lines;
+		LocalCodeTable codes;  // Area and country codes of lines
+		bool is_last = false;
+		bool is_partial = false;
+	};
+
+	struct navaid_merge_key_t
+	// Navaids that can be merged with each other have the same key or keys 
+	// of neighboring cells.
+	{
+		std::string id;
+		uint64_t freq_bits;
+		int64_t lat_cell, lon_cell;
+
+
+		bool operator==(const navaid_merge_key_t& other) const;
+	};
+
+	struct navaid_merge_key_hash_t
+	{
+		size_t operator()(const navaid_merge_key_t& key) const;
+	};
+
+	// Maps merge keys to indices of navaids in the vector stored under the same id
+	typedef std::unordered_map<navaid_merge_key_t, std::vector<size_t>, 
+		navaid_merge_key_hash_t> navaid_merge_idx_t;
+
+
+	/*
+		Snapshot file layout:
+		navaid_snap_hdr_t
+		navaid_snap_navaid_t[n_navaids]
+		navaid_snap_wpt_t[n_wpts]
+		char[str_sz]  String table. Strings aren't null-terminated.
+		The file doesn't contain any pointers. Strings are referenced by their offset
+		in the string table and navaids by their index.
+	*/
+
+	struct navaid_snap_hdr_t
+	{
+		char magic[NAVAID_SNAP_MAGIC_SZ];
+		uint32_t version;
+		uint32_t byte_order;
+		int32_t wpt_airac_cycle, wpt_db_version;
+		int32_t navaid_airac_cycle, navaid_db_version;
+		uint64_t n_navaids, n_wpts;
+		uint64_t str_sz;
+	};
+
+	struct navaid_snap_str_t
+	{
+		uint32_t offset, len;
+	};
+
+	struct navaid_snap_navaid_t
+	{
+		double elev_ft, freq, mag_var;
+		uint16_t max_recv;
+		uint16_t pad[3];
+	};
+
+	struct navaid_snap_wpt_t
+	// Entries with the same id are stored next to each other in their original order
+	{
+		navaid_snap_str_t id, area_code, country_code, desc;
+		uint32_t type;
+		uint32_t arinc_type;
+		double lat_rad, lon_rad;
+		uint64_t navaid_idx;  // NAVAID_SNAP_NO_NAVAID if the entry isn't a navaid
+	};
+
+
 	class NavaidDB
 	{
 	public:
@@ -179,7 +316,24 @@ namespace libnav
 		DbErr err_code;
 
 
-		NavaidDB(std::string wpt_path, std::string navaid_path);
+		/*
+			n_load_thr is the number of threads that parse each of the files. Each file is
+			split into n_load_thr line-aligned chunks that are parsed into thread-local 
+			shards. The shards are merged once all of them have been loaded. 
+			0 means that std::thread::hardware_concurrency() threads will be used.
+		*/
+
+		NavaidDB(std::string wpt_path, std::string navaid_path, size_t n_load_thr=1);
+
+		/*
+			Loads the data base from a snapshot created by save_snapshot. The file is
+			mapped into memory and copied into the caches directly, no text is parsed.
+			Both get_wpt_err and get_navaid_err return the result of the load:
+			DATA_BASE_ERROR if the snapshot is damaged or was written by an incompatible
+			version of libnav.
+		*/
+
+		NavaidDB(std::string snap_path);
 
 		DbErr get_wpt_err();
 		 
@@ -193,23 +347,84 @@ namespace libnav
 
 		int get_navaid_version();
 
+		// The loaders can't be called once the data base is frozen. 
+		// They return DATA_BASE_ERROR in that case.
+
 		DbErr load_waypoints();
 
 		DbErr load_navaids();
 
+		/*
+			Function: is_frozen
+			Description:
+			The data base is frozen once both loaders have finished. After that its
+			contents never change, so queries don't take any locks.
+			@return: true if the data base is frozen, false otherwise.
+		*/
+
+		bool is_frozen();
+
 		const wpt_db_t& get_db();
 
-		bool is_wpt(std::string id);
+		bool is_wpt(const std::string& id);
 
-		bool is_navaid_of_type(std::string id, NavaidType type);
+		bool is_navaid_of_type(const std::string& id, NavaidType type);
 
 		// get_wpt_data returns 0 if waypoint is not in the database. 
 		// Otherwise, returns number of items written to out.
-		size_t get_wpt_data(std::string& id, std::vector<waypoint_entry_t>* out, 
-			std::string area_code="", std::string country_code="", 
+		size_t get_wpt_data(const std::string& id, std::vector<waypoint_entry_t>* out, 
+			const std::string& area_code="", const std::string& country_code="", 
 			NavaidType type=NavaidType::NAVAID, 
 			navaid_filter_t filt_func=default_navaid_filter, void* ref=NULL);
 
+		/*
+			Function: find_wpt_entries
+			Description:
+			Gets all entries stored under an id without copying them. Ids passed as 
+			const char* that fit into the small string buffer don't allocate.
+			@param id: waypoint/navaid id
+			@return: pointer to the entries or nullptr if there are none. nullptr is also
+			returned until the data base is frozen, since the entries may still move.
+		*/
+
+		const std::vector<waypoint_entry_t>* find_wpt_entries(const std::string& id);
+
+		/*
+			Function: visit_wpt_data
+			Description:
+			Same as get_wpt_data, but passes references to the matching entries to
+			a visitor instead of copying them. If the data base isn't frozen yet, 
+			the visitor is called with the data base locked, so it must not call
+			back into the data base.
+			@param id: waypoint/navaid id
+			@param visitor: function that is called for every matching entry
+			@param ref: pointer passed to visitor
+			@param area_code: area code filter. Empty string matches any code.
+			@param country_code: country code filter. Empty string matches any code.
+			@param type: type mask. NONE matches any type.
+			@return: number of entries passed to visitor.
+		*/
+
+		size_t visit_wpt_data(const std::string& id, wpt_visitor_t visitor, void* ref,
+			const std::string& area_code="", const std::string& country_code="", 
+			NavaidType type=NavaidType::NAVAID);
+
+		/*
+			Function: get_wpt_nearest
+			Description:
+			Finds the entry of an id that is closest to a point, e.g. to resolve a
+			duplicate ident. The entries are scanned once without being copied or
+			sorted.
+			@param id: waypoint/navaid id
+			@param pos: reference point
+			@param out: pointer to the output entry
+			@param type: type mask. NONE matches any type.
+			@return: true if a matching entry has been found.
+		*/
+
+		bool get_wpt_nearest(const std::string& id, geo::point pos, 
+			waypoint_entry_t* out, NavaidType type=NavaidType::NAVAID);
+
 		/*
 			Function: get_wpt_by_awy_str
 			Description:
@@ -232,8 +447,75 @@ namespace libnav
 
 		size_t get_wpt_by_hold_str(std::string& hold_str, std::vector<waypoint_entry_t>* out);
 
+		/*
+			Function: get_fix_desc
+			Description:
+			Gets the description(spoken name) of a waypoint. If the waypoint doesn't
+			come from this data base, its description is looked up by id, area code
+			and country code.
+			@param fix: waypoint
+			@return: description or empty string if there is none.
+		*/
+
 		std::string get_fix_desc(waypoint_t& fix);
 
+		/*
+			Function: find_fix_desc
+			Description:
+			Gets the description of an entry of this data base without copying it.
+			@param entry: waypoint entry returned by this data base
+			@return: null-terminated description or nullptr if the data base hasn't 
+			been loaded yet.
+		*/
+
+		const char* find_fix_desc(const waypoint_entry_t& entry);
+
+		/*
+			Function: get_in_radius
+			Description:
+			Finds all waypoints and navaids within a great circle distance of a point.
+			The spatial index is built by the first call after the data base has been 
+			loaded, so this shouldn't be called while get_wpt_err or get_navaid_err 
+			are being waited on by other threads.
+			@param p: center of the search
+			@param dist_nm: search radius
+			@param type: only entries whose type has common bits with type are written.
+			NONE means any type.
+			@param out: pointer to the output vector. Results are appended in no
+			particular order.
+			@return: number of items written to out.
+		*/
+
+		size_t get_in_radius(geo::point p, double dist_nm, NavaidType type,
+			std::vector<waypoint_t>* out);
+
+		/*
+			Function: get_k_nearest
+			Description:
+			Finds k waypoints/navaids nearest to a point. See get_in_radius.
+			@param p: center of the search
+			@param k: maximum number of items to find
+			@param type: type mask. NONE means any type.
+			@param out: pointer to the output vector. Results are appended in order of
+			increasing distance.
+			@return: number of items written to out.
+		*/
+
+		size_t get_k_nearest(geo::point p, size_t k, NavaidType type,
+			std::vector<waypoint_t>* out);
+
+		/*
+			Function: save_snapshot
+			Description:
+			Saves the contents of the data base along with its airac cycles and versions
+			to a binary file that can be loaded by NavaidDB(snap_path).
+			Waits for the data base to finish loading.
+			@param path: path to the output file
+			@return: SUCCESS or FILE_NOT_FOUND if the file couldn't be written.
+		*/
+
+		DbErr save_snapshot(std::string path);
+
 		void reset();
 
 		~NavaidDB();
@@ -241,6 +523,7 @@ namespace libnav
 	private:
 		int wpt_airac_cycle, wpt_db_version;
 		int navaid_airac_cycle, navaid_db_version;
+		size_t n_load_threads;
 
 		std::string sim_wpt_db_path;
 		std::string sim_navaid_db_path;
@@ -251,39 +534,124 @@ namespace libnav
 		std::mutex wpt_db_mutex;
 		std::mutex navaid_db_mutex;
 
-		std::mutex wpt_desc_mutex;
-		std::mutex navaid_desc_mutex;
+		std::mutex desc_mutex;
+
+		std::atomic<int> n_loaders_done;
+		std::atomic<bool> frozen;
+		// Codes used by the entries of this data base. Filled in when the data base
+		// is frozen, so that it can be read without locking the global code table.
+		std::unordered_map<std::string, code_id_t> db_codes;
 
 		wpt_db_t wpt_cache;
-		navaid_entry_t* navaid_entries;
-		size_t n_navaid_entries;
+		// Waypoint entries point into this, so its items must never move.
+		ChunkArena<navaid_entry_t> navaid_entries{NAVAID_ENTRY_CHUNK_SZ};
 
-		std::unordered_map<std::string, std::string> wpt_desc_db;
-		std::unordered_map<std::string, std::string> navaid_desc_db;
+		// Null-terminated descriptions of all entries. Starts with an empty string,
+		// so that offset 0 means no description.
+		std::string desc_pool = std::string(1, '\0');
+
+		std::mutex grid_mutex;
+		std::atomic<bool> grid_built;
+		GeoGrid wpt_grid;
+		// Grid item i refers to *grid_entries[i] stored under key *grid_ids[i].
+		std::vector<const std::string*> grid_ids;
+		std::vector<const waypoint_entry_t*> grid_entries;
 
 
 		navaid_entry_t* navaid_entries_add(navaid_entry_t data);
 
-		void add_to_wpt_cache(waypoint_t wpt);
+		// Merges waypoints loaded by one of the loaders into wpt_cache. 
+		// src is left in unspecified state.
+		void merge_to_wpt_cache(wpt_db_t& src);
+
+		// Appends a loader-local description pool to desc_pool and moves the
+		// description offsets of entries in db so that they point into desc_pool.
+		// If codes isn't nullptr, local code ids of the entries are replaced with 
+		// global ones.
+		void merge_desc_pool(wpt_db_t& db, std::string& pool, 
+			const LocalCodeTable* codes=nullptr);
+
+		void add_to_navaid_cache(wpt_db_t& db, navaid_merge_idx_t& merge_idx, 
+			waypoint_t& wpt, navaid_entry_t data);
+
+		DbErr load_snapshot(std::string& path);
 
-		void add_to_navaid_cache(waypoint_t wpt, navaid_entry_t data);
+		// Called by each loader task when it's done. The last one freezes the data base.
+		void on_loader_done();
 
+		void freeze();
 
-		static std::string get_fix_unique_ident(waypoint_t& fix);
+		bool find_db_code(const std::string& s, code_id_t* out);
 
-		static void add_to_map_with_mutex(std::string& id, std::string& desc,
-			std::mutex& mtx, std::unordered_map<std::string, std::string>& umap);
+		// Resolves area and country filters of a query. Returns false if the filters
+		// can't match anything.
+		bool get_code_filt(const std::string& area_code, const std::string& country_code,
+			code_id_t* area_id, code_id_t* country_id);
 
-		static std::string get_map_val_with_mutex(std::string& id,
-			std::mutex& mtx, std::unordered_map<std::string, std::string>& umap);
+		void build_grid();
+
+
+		static bool grid_type_filter(size_t idx, void* ref);
+
+		static bool is_entry_match(const waypoint_entry_t& entry, code_id_t area_id,
+			code_id_t country_id, NavaidType type);
+
+		static void load_wpt_chunk(const char* beg, const char* end, int db_version,
+			wpt_shard_t* out);
+
+		static void load_navaid_chunk(const char* beg, const char* end, 
+			navaid_shard_t* out);
+
+		static void append_wpt_db(wpt_db_t& dst, wpt_db_t& src);
+
+		// Adds a description to a pool that starts with an empty string.
+		// Returns its offset.
+		static uint32_t add_desc(std::string& pool, const char* s, size_t len);
+
+		static navaid_snap_str_t add_snap_str(std::string& str_tbl, const std::string& s);
+
+		static bool get_snap_str(const char* str_tbl, uint64_t str_sz, 
+			navaid_snap_str_t s, std::string* out);
 	};
 
 
 	std::string navaid_to_str(NavaidType navaid_type);
 
-	void sort_wpt_entry_by_dist(std::vector<waypoint_entry_t>* vec, geo::point p);
+	/*
+		Function: rank_wpt_entries_by_dist
+		Description:
+		Finds the entries nearest to a point without moving them. Every distance is
+		calculated once, and only the k nearest entries are sorted.
+		@param vec: entries to rank
+		@param p: reference point
+		@param k: maximum number of entries to rank
+		@param out: pointer to the output vector. It is cleared first. Indices of the 
+		k nearest entries in vec are written to it in order of increasing distance.
+		@return: number of items written to out.
+	*/
+
+	size_t rank_wpt_entries_by_dist(const std::vector<waypoint_entry_t>& vec, 
+		geo::point p, size_t k, std::vector<size_t>* out);
+
+	size_t rank_wpts_by_dist(const std::vector<waypoint_t>& vec, geo::point p, 
+		size_t k, std::vector<size_t>* out);
+
+	/*
+		Function: sort_wpt_entry_by_dist
+		Description:
+		Sorts entries by distance to a point. If k is given, only the k nearest 
+		entries are sorted. They are moved to the front of vec and the rest keep 
+		their relative order.
+		@param vec: pointer to the entries
+		@param p: reference point
+		@param k: number of entries to sort
+	*/
+
+	void sort_wpt_entry_by_dist(std::vector<waypoint_entry_t>* vec, geo::point p, 
+		size_t k=SIZE_MAX);
 
-	void sort_wpts_by_dist(std::vector<waypoint_t>* vec, geo::point p);
+	void sort_wpts_by_dist(std::vector<waypoint_t>* vec, geo::point p, 
+		size_t k=SIZE_MAX);
 
 }; // namespace libnav
 
@@ -335,6 +703,27 @@ namespace radnav_util
 
 	double get_dme_dme_qual(double phi_deg, double q1, double q2);
 
+	/*
+		Function: get_navaid_qual
+		Description:
+		This function calculates the quality ratio for a navaid. Navaids are sorted
+		by this ratio to determine the best suitable candidate(s) for radio navigation.
+		@param data: navaid entry
+		@param ac_pos: position of the aircraft
+		@return: value between 0 and 1 or -1 if the navaid can't be received.
+	*/
+
+	double get_navaid_qual(const libnav::waypoint_entry_t& data, geo::point3d ac_pos);
+
+	/*
+		Same as above, but navaids that are out of range are rejected using
+		geo::nvec::get_approx_dist_nm before the exact distance is calculated.
+		ac_nv must be the n-vector of ac_pos.p.
+	*/
+
+	double get_navaid_qual(const libnav::waypoint_entry_t& data, geo::point3d ac_pos,
+		const geo::nvec& ac_nv);
+
 
 	struct navaid_t
 	{
@@ -342,13 +731,10 @@ namespace radnav_util
 		libnav::waypoint_entry_t data;
 		double qual;
 
-		/*
-			This function calculates the quality ratio for a navaid.
-			Navaids are sorted by this ratio to determine the best 
-			suitable candidate(s) for radio navigation.
-		*/
-
+		// Sets qual using get_navaid_qual
 		void calc_qual(geo::point3d ac_pos);
+
+		void calc_qual(geo::point3d ac_pos, const geo::nvec& ac_nv);
 	};
 
 	struct navaid_pair_t
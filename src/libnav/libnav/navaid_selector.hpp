@@ -0,0 +1,186 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of member functions for NavaidSelector and
+	NavaidTracker classes. NavaidSelector picks the best VOR/DME stations and DME/DME
+	pairs for radio navigation at a given aircraft position. NavaidTracker does the
+	same, but keeps its state between updates, so that it can be called every frame.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "navaid_db.hpp"
+
+
+namespace radnav_util
+{
+	// Navaid types that can be used for DME/DME position calculation
+	constexpr int RADNAV_DME_TYPES = static_cast<int>(libnav::NavaidType::DME) +
+		static_cast<int>(libnav::NavaidType::DME_ONLY) +
+		static_cast<int>(libnav::NavaidType::VOR_DME);
+	constexpr int RADNAV_VOR_DME_TYPES = static_cast<int>(libnav::NavaidType::VOR_DME);
+	// NavaidTracker re-reads the data base once the aircraft moves further than this
+	// from the position of the last read.
+	constexpr double NAVAID_TRACKER_MARGIN_NM = 20;
+
+
+	/*
+		Function: get_max_dme_recv_nm
+		Description:
+		@param db: navaid data base. Must be loaded.
+		@return: largest reception range of all DMEs in the data base.
+	*/
+
+	double get_max_dme_recv_nm(std::shared_ptr<libnav::NavaidDB> db);
+
+	/*
+		Function: get_best_dme_pairs
+		Description:
+		Finds the best DME/DME pairs.
+		@param dmes: receivable DMEs sorted by quality, best first
+		@param ac_pos: position of the aircraft
+		@param k: maximum number of pairs
+		@param out: pointer to the output vector. It is cleared first. Pairs are
+		sorted by quality, best first.
+		@return: number of items written to out.
+	*/
+
+	size_t get_best_dme_pairs(std::vector<navaid_t*>& dmes, geo::point ac_pos,
+		size_t k, std::vector<navaid_pair_t>* out);
+
+
+	class NavaidSelector
+	{
+	public:
+		/*
+			Function: NavaidSelector
+			Description:
+			@param db: navaid data base
+			@param n_vor_dme: maximum number of VOR/DME candidates
+			@param n_dme_dme: maximum number of DME/DME candidates
+		*/
+
+		NavaidSelector(std::shared_ptr<libnav::NavaidDB> db, size_t n_vor_dme,
+			size_t n_dme_dme);
+
+		/*
+			Function: update
+			Description:
+			Recalculates the candidates for a new aircraft position. Only navaids
+			within max_recv of the aircraft and below VOR_MAX_SLANT_ANGLE_DEG are
+			considered. Pairs of DMEs must have an encounter angle between
+			DME_DME_PHI_MIN_DEG and DME_DME_PHI_MAX_DEG.
+			@param ac_pos: position of the aircraft
+			@return: false if the data base hasn't been loaded yet.
+		*/
+
+		bool update(geo::point3d ac_pos);
+
+		// VOR/DME candidates sorted by quality, best first.
+		const std::vector<navaid_t>& get_vor_dme();
+
+		// DME/DME candidates sorted by quality, best first. The pairs point to
+		// navaids stored in the selector, so they are valid until the next update.
+		const std::vector<navaid_pair_t>& get_dme_dme();
+
+	private:
+		std::shared_ptr<libnav::NavaidDB> navaid_db;
+		size_t n_vor_dme_max, n_dme_dme_max;
+		// Largest reception range of all DMEs in the data base
+		double max_recv_nm;
+
+		std::vector<libnav::waypoint_t> in_rng;
+		// Receivable DMEs sorted by quality
+		std::vector<navaid_t> dmes;
+		std::vector<navaid_t*> dme_ptrs;
+
+		std::vector<navaid_t> vor_dme;
+		std::vector<navaid_pair_t> dme_dme;
+
+
+		void update_vor_dme();
+	};
+
+	class NavaidTracker
+	{
+	public:
+		/*
+			Function: NavaidTracker
+			Description:
+			@param db: navaid data base
+			@param n_vor_dme: maximum number of VOR/DME candidates
+			@param n_dme_dme: maximum number of DME/DME candidates
+			@param margin_nm: the data base is read again once the aircraft moves
+			further than this from the position of the last read.
+		*/
+
+		NavaidTracker(std::shared_ptr<libnav::NavaidDB> db, size_t n_vor_dme,
+			size_t n_dme_dme, double margin_nm=NAVAID_TRACKER_MARGIN_NM);
+
+		/*
+			Function: update
+			Description:
+			Updates the set of receivable stations and the candidates for a new
+			aircraft position. The spatial index is only queried when the aircraft
+			has moved further than margin_nm since the last query. Otherwise only
+			the stations that could become receivable within the margin are checked.
+			@param ac_pos: position of the aircraft
+			@return: false if the data base hasn't been loaded yet.
+		*/
+
+		bool update(geo::point3d ac_pos);
+
+		// Receivable DMEs sorted by quality, best first.
+		const std::vector<navaid_t*>& get_stations();
+
+		// Stations that became receivable during the last update
+		const std::vector<navaid_t*>& get_added();
+
+		// Stations that stopped being receivable during the last update. These are
+		// copies, since the stations might not be tracked anymore.
+		const std::vector<navaid_t>& get_removed();
+
+		// VOR/DME candidates sorted by quality, best first.
+		const std::vector<navaid_t*>& get_vor_dme();
+
+		// DME/DME candidates sorted by quality, best first.
+		const std::vector<navaid_pair_t>& get_dme_dme();
+
+	private:
+		std::shared_ptr<libnav::NavaidDB> navaid_db;
+		size_t n_vor_dme_max, n_dme_dme_max;
+		double margin_nm;
+		double max_recv_nm;
+
+		bool has_ref_pos;
+		geo::point ref_pos;  // Position of the last data base query
+
+		// Stations that are within their max_recv + margin_nm of ref_pos.
+		// Pointers to these stay valid until the next data base query.
+		std::vector<navaid_t> tracked;
+		std::vector<bool> is_recv;
+		// Lower bounds of the distances from ref_pos to the stations
+		std::vector<double> ref_dist_nm;
+
+		std::vector<navaid_t*> recv;
+		std::vector<navaid_t*> added;
+		std::vector<navaid_t> removed;
+
+		std::vector<navaid_t*> vor_dme;
+		std::vector<navaid_pair_t> dme_dme;
+
+		std::vector<libnav::waypoint_t> in_rng;
+
+
+		void update_tracked(geo::point3d ac_pos);
+	};
+}; // namespace radnav_util
@@ -0,0 +1,146 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains declarations of member functions for RadnavFilter class.
+	RadnavFilter blends DME ranges and VOR radials into a position estimate using
+	an extended Kalman filter. The state is the position and the ground velocity in
+	the local east/north plane. Measurements are processed one at a time, so an
+	update doesn't allocate any memory. A filter is a couple hundred bytes, so one
+	can be kept for every simulated aircraft.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "navaid_db.hpp"
+
+
+namespace radnav_util
+{
+	// Standard deviation of the acceleration of the aircraft in each axis. About
+	// the acceleration in a standard rate turn at 200 kts.
+	constexpr double RADNAV_FILTER_ACC_SIGMA_KT_S = 10;
+	// Standard deviation of the velocity when the filter starts, kts
+	constexpr double RADNAV_FILTER_INIT_VEL_SIGMA_KT = 300;
+	// Measurements whose innovation exceeds this many standard deviations are rejected
+	constexpr double RADNAV_FILTER_GATE_SIGMA = 5;
+	// The filter is restarted after this many updates in a row in which all
+	// measurements have been rejected.
+	constexpr size_t RADNAV_FILTER_MAX_REJ_UPDATES = 50;
+
+
+	struct radnav_meas_t
+	{
+		const libnav::waypoint_entry_t* stn;  // Station. Must have navaid data.
+		bool has_dme, has_vor;
+		double dist_nm;  // Measured slant range
+		double radial_rad;  // Measured true radial, i.e. bearing from the station
+	};
+
+	struct radnav_est_t
+	{
+		geo::point pos;
+		// Ground velocity, kts
+		double vel_e_kt, vel_n_kt;
+		// Covariance of the position in a local frame, nm^2
+		double cov_ee, cov_en, cov_nn;
+		// Actual navigation performance: 2 * drms, nm
+		double anp_nm;
+		// Number of measurements used and rejected by the last update
+		size_t n_used, n_rej;
+	};
+
+
+	class RadnavFilter
+	{
+	public:
+		/*
+			Function: RadnavFilter
+			Description:
+			@param acc_sigma_kt_s: standard deviation of the acceleration of the aircraft
+			@param gate_sigma: measurements whose innovation exceeds this many standard
+			deviations are rejected
+		*/
+
+		RadnavFilter(double acc_sigma_kt_s=RADNAV_FILTER_ACC_SIGMA_KT_S,
+			double gate_sigma=RADNAV_FILTER_GATE_SIGMA);
+
+		/*
+			Function: reset
+			Description:
+			Discards the estimate. The next update will start from scratch.
+		*/
+
+		void reset();
+
+		/*
+			Function: set_guess
+			Description:
+			Sets an approximate aircraft position, which is used to pick one of the 2
+			DME/DME solutions when the filter starts.
+			@param guess_pos: approximate aircraft position
+		*/
+
+		void set_guess(geo::point guess_pos);
+
+		bool is_init();
+
+		/*
+			Function: update
+			Description:
+			Propagates the estimate by dt_sec and applies the measurements. If there is
+			no estimate yet, the filter is started from the VOR DME or DME/DME fix with
+			the smallest FOM. DME/DME fixes are only used if one of the 2 solutions can
+			be picked using the guess or the other measurements. Measurements from
+			stations that can't be received at the estimated position are ignored.
+			Doesn't allocate memory.
+			@param dt_sec: time since the last update
+			@param meas: measurements
+			@param ac_alt_ft: altitude of the aircraft AMSL
+			@param out: pointer to the output estimate
+			@return: true if there is an estimate.
+		*/
+
+		bool update(double dt_sec, const std::vector<radnav_meas_t>& meas, double ac_alt_ft,
+			radnav_est_t* out);
+
+	private:
+		double acc_var, gate_sq;
+
+		bool has_guess;
+		geo::point guess;
+
+		bool is_filter_init;
+		size_t n_rej_updates;
+		geo::point pos;
+		// State: east and north displacement(nm), east and north velocity(nm/s)
+		double vel_e, vel_n;
+		double cov[4][4];
+		size_t n_used_last, n_rej_last;
+
+
+		void predict(double dt_sec);
+
+		// Applies a scalar measurement with derivatives h_e and h_n by east and north
+		// displacement. Returns false if it has been rejected by the gate.
+		bool apply_meas(double innov, double h_e, double h_n, double var);
+
+		void move_pos(double d_e_nm, double d_n_nm);
+
+		bool start(const std::vector<radnav_meas_t>& meas, double ac_alt_ft);
+
+		// Returns the sum of squared normalized residuals of the measurements at p.
+		// DME ranges of measurements with indices skip_1 and skip_2 are skipped.
+		static double get_cost(const std::vector<radnav_meas_t>& meas, geo::point p,
+			double ac_alt_ft, size_t skip_1, size_t skip_2, size_t* n_meas);
+
+		void get_est(radnav_est_t* out);
+	};
+}; // namespace radnav_util
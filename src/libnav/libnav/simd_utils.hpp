@@ -0,0 +1,110 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains thin wrappers around SIMD intrinsics, so that the batch
+	kernels are written once for AVX and SSE2. AVX is used when the library is built
+	with it(see LIBNAV_AVX2 option), SSE2 on other x86-64 builds. LIBNAV_SIMD isn't
+	defined on other targets and the batch functions fall back to plain loops.
+	This header is only meant to be included by libnav source files.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LIBNAV_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIBNAV_SIMD
+#endif
+
+
+#ifdef LIBNAV_SIMD
+namespace simd_utils
+{
+#if defined(__AVX__)
+	typedef __m256d vec_t;
+	constexpr size_t N_VEC_LANES = 4;
+
+	inline vec_t vec_set(double v) { return _mm256_set1_pd(v); }
+	inline vec_t vec_load(const double* p) { return _mm256_loadu_pd(p); }
+	inline void vec_store(double* p, vec_t v) { _mm256_storeu_pd(p, v); }
+	inline vec_t vec_add(vec_t a, vec_t b) { return _mm256_add_pd(a, b); }
+	inline vec_t vec_sub(vec_t a, vec_t b) { return _mm256_sub_pd(a, b); }
+	inline vec_t vec_mul(vec_t a, vec_t b) { return _mm256_mul_pd(a, b); }
+	inline vec_t vec_div(vec_t a, vec_t b) { return _mm256_div_pd(a, b); }
+	inline vec_t vec_sqrt(vec_t a) { return _mm256_sqrt_pd(a); }
+	// Returns a if a > b, b otherwise. NaNs in a are replaced by b.
+	inline vec_t vec_max(vec_t a, vec_t b) { return _mm256_max_pd(a, b); }
+	// Returns a if a < b, b otherwise. NaNs in a are replaced by b.
+	inline vec_t vec_min(vec_t a, vec_t b) { return _mm256_min_pd(a, b); }
+	inline vec_t vec_and(vec_t a, vec_t b) { return _mm256_and_pd(a, b); }
+	inline vec_t vec_or(vec_t a, vec_t b) { return _mm256_or_pd(a, b); }
+	inline vec_t vec_xor(vec_t a, vec_t b) { return _mm256_xor_pd(a, b); }
+	// Returns ~a & b
+	inline vec_t vec_andnot(vec_t a, vec_t b) { return _mm256_andnot_pd(a, b); }
+	// Comparisons return all ones where true, 0 elsewhere
+	inline vec_t vec_cmp_eq(vec_t a, vec_t b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+	inline vec_t vec_cmp_lt(vec_t a, vec_t b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	inline vec_t vec_cmp_gt(vec_t a, vec_t b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	// Returns a where mask_src != 0, 0 elsewhere
+	inline vec_t vec_and_nonzero(vec_t a, vec_t mask_src)
+	{
+		vec_t mask = _mm256_cmp_pd(mask_src, _mm256_setzero_pd(), _CMP_NEQ_UQ);
+		return _mm256_and_pd(a, mask);
+	}
+#else
+	typedef __m128d vec_t;
+	constexpr size_t N_VEC_LANES = 2;
+
+	inline vec_t vec_set(double v) { return _mm_set1_pd(v); }
+	inline vec_t vec_load(const double* p) { return _mm_loadu_pd(p); }
+	inline void vec_store(double* p, vec_t v) { _mm_storeu_pd(p, v); }
+	inline vec_t vec_add(vec_t a, vec_t b) { return _mm_add_pd(a, b); }
+	inline vec_t vec_sub(vec_t a, vec_t b) { return _mm_sub_pd(a, b); }
+	inline vec_t vec_mul(vec_t a, vec_t b) { return _mm_mul_pd(a, b); }
+	inline vec_t vec_div(vec_t a, vec_t b) { return _mm_div_pd(a, b); }
+	inline vec_t vec_sqrt(vec_t a) { return _mm_sqrt_pd(a); }
+	inline vec_t vec_max(vec_t a, vec_t b) { return _mm_max_pd(a, b); }
+	inline vec_t vec_min(vec_t a, vec_t b) { return _mm_min_pd(a, b); }
+	inline vec_t vec_and(vec_t a, vec_t b) { return _mm_and_pd(a, b); }
+	inline vec_t vec_or(vec_t a, vec_t b) { return _mm_or_pd(a, b); }
+	inline vec_t vec_xor(vec_t a, vec_t b) { return _mm_xor_pd(a, b); }
+	inline vec_t vec_andnot(vec_t a, vec_t b) { return _mm_andnot_pd(a, b); }
+	inline vec_t vec_cmp_eq(vec_t a, vec_t b) { return _mm_cmpeq_pd(a, b); }
+	inline vec_t vec_cmp_lt(vec_t a, vec_t b) { return _mm_cmplt_pd(a, b); }
+	inline vec_t vec_cmp_gt(vec_t a, vec_t b) { return _mm_cmpgt_pd(a, b); }
+	inline vec_t vec_and_nonzero(vec_t a, vec_t mask_src)
+	{
+		vec_t mask = _mm_cmpneq_pd(mask_src, _mm_setzero_pd());
+		return _mm_and_pd(a, mask);
+	}
+#endif
+
+	// Returns a where mask is set, b elsewhere
+	inline vec_t vec_select(vec_t mask, vec_t a, vec_t b)
+	{
+		return vec_or(vec_and(mask, a), vec_andnot(mask, b));
+	}
+
+	inline vec_t vec_abs(vec_t a)
+	{
+		return vec_andnot(vec_set(-0.0), a);
+	}
+
+	// Rounds to the nearest integer. |a| must be less than 2^51.
+	inline vec_t vec_round(vec_t a)
+	{
+		const vec_t magic = vec_set(6755399441055744.0);  // 1.5 * 2^52
+		return vec_sub(vec_add(a, magic), magic);
+	}
+}; // namespace simd_utils
+#endif
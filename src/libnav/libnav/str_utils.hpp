@@ -21,6 +21,8 @@
 #include <math.h>
 #include <iostream>
 #include <cstdint>
+#include <cstring>
+#include <cstdlib>
 
 
 namespace strutils
@@ -342,6 +344,296 @@ namespace strutils
 		return 0;
 	}
 
+	/*
+		str_view_t is a non-owning pointer/length pair. It's used by the zero-copy
+		parsers, which tokenize lines of memory-mapped files in place.
+	*/
+
+	struct str_view_t
+	{
+		const char* ptr = nullptr;
+		size_t len = 0;
+
+
+		bool operator==(const char* other) const
+		{
+			size_t i = 0;
+			while (i < len && other[i] != '\0' && other[i] == ptr[i])
+			{
+				i++;
+			}
+			return i == len && other[i] == '\0';
+		}
+
+		bool operator!=(const char* other) const
+		{
+			return !(*this == other);
+		}
+
+		std::string to_str() const
+		{
+			return std::string(ptr, len);
+		}
+	};
+
+	/*
+		Function: strip_view
+		Description: same as strip, but doesn't copy the string.
+		@param in: input view
+		@param sep: separator
+		@Return: stripped view
+	*/
+
+	inline str_view_t strip_view(str_view_t in, char sep=' ')
+	{
+		while (in.len && in.ptr[0] == sep)
+		{
+			in.ptr++;
+			in.len--;
+		}
+		while (in.len && in.ptr[in.len-1] == sep)
+		{
+			in.len--;
+		}
+		return in;
+	}
+
+	/*
+		Function: str_split_view
+		Description: splits the string by a designated character in the same way as
+		str_split does, without allocating any memory.
+		@param in: pointer to the first character of the string
+		@param len: length of the string
+		@param out: pointer to the output array. Must hold at least n_split+1 items.
+		@param n_split: maximum number of columns to separate
+		@param sep: separator
+		@Return: number of items written to out
+	*/
+
+	inline size_t str_split_view(const char* in, size_t len, str_view_t* out,
+		int n_split, char sep=' ')
+	{
+		size_t n_out = 0;
+		size_t i = 0;
+
+		while (n_split && i < len)
+		{
+			size_t j = i;
+			while (j < len && in[j] != sep)
+			{
+				j++;
+			}
+			if (j != i)
+			{
+				n_split--;
+				out[n_out] = strip_view({in + i, j - i}, '\r');
+				n_out++;
+			}
+			i = j + 1;
+		}
+		if (!n_split && i < len)
+		{
+			out[n_out] = strip_view({in + i, len - i}, '\r');
+			n_out++;
+		}
+
+		return n_out;
+	}
+
+	// Size of the buffer used to convert a str_view_t to a number
+	constexpr size_t N_VIEW_NUM_BUF_SZ = 64;
+	// Numbers with more digits than this are converted using the C library
+	constexpr int N_VIEW_FAST_MAX_DIGITS = 18;
+	// Largest power of 10 that is exactly representable as a double
+	constexpr int N_VIEW_FAST_MAX_EXP = 22;
+
+	/*
+		Function: view_to_c_str
+		Description: copies the leading part of the view into buf and null-terminates it.
+		Only the leading part of the string is ever used by atoi/atof anyway.
+	*/
+
+	inline void view_to_c_str(str_view_t s, char* buf)
+	{
+		if (s.len >= N_VIEW_NUM_BUF_SZ)
+		{
+			s.len = N_VIEW_NUM_BUF_SZ - 1;
+		}
+		memcpy(buf, s.ptr, s.len);
+		buf[s.len] = '\0';
+	}
+
+	/*
+		Function: view_to_int
+		Description: same as stoi_with_strip, but for views.
+	*/
+
+	inline int view_to_int(str_view_t s)
+	{
+		s = strip_view(s);
+		if (s.len == 0)
+		{
+			return 0;
+		}
+
+		size_t i = 0;
+		bool is_neg = s.ptr[0] == '-';
+		if (is_neg || s.ptr[0] == '+')
+		{
+			i++;
+		}
+		int out = 0;
+		int n_digits = 0;
+		while (i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9' && n_digits < 9)
+		{
+			out = out * 10 + (s.ptr[i] - '0');
+			n_digits++;
+			i++;
+		}
+		if (n_digits == 0 || (i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'))
+		{
+			// Leading white space or possible overflow. Leave it to the C library.
+			char buf[N_VIEW_NUM_BUF_SZ];
+			view_to_c_str(s, buf);
+			return atoi(buf);
+		}
+		return is_neg ? -out : out;
+	}
+
+	/*
+		Function: view_to_double
+		Description: converts a view to double. The result is always the same as
+		the one of atof: numbers that have a short decimal representation are parsed
+		directly(an integer mantissa divided by an exact power of 10 is correctly rounded),
+		everything else is passed on to the C library.
+	*/
+
+	inline double view_to_double(str_view_t s)
+	{
+		static const double pow_10[N_VIEW_FAST_MAX_EXP+1] = {1e0, 1e1, 1e2, 1e3, 1e4, 
+			1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 
+			1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+		s = strip_view(s);
+		if (s.len == 0)
+		{
+			return 0;
+		}
+
+		size_t i = 0;
+		bool is_neg = s.ptr[0] == '-';
+		if (is_neg || s.ptr[0] == '+')
+		{
+			i++;
+		}
+		uint64_t mantissa = 0;
+		int n_digits = 0;
+		int n_frac = 0;
+		bool has_dot = false;
+		for (; i < s.len; i++)
+		{
+			char c = s.ptr[i];
+			if (c >= '0' && c <= '9')
+			{
+				mantissa = mantissa * 10 + uint64_t(c - '0');
+				n_digits++;
+				n_frac += int(has_dot);
+			}
+			else if (c == '.' && !has_dot)
+			{
+				has_dot = true;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		bool is_fast = n_digits > 0 && n_digits <= N_VIEW_FAST_MAX_DIGITS && 
+			(mantissa >> 53) == 0 && n_frac <= N_VIEW_FAST_MAX_EXP;
+		if (i < s.len)
+		{
+			// Exponents, hex numbers, inf and nan are handled by the C library
+			char c = char(tolower(s.ptr[i]));
+			is_fast = is_fast && c != 'e' && c != 'x' && c != 'i' && c != 'n';
+		}
+		if (!is_fast)
+		{
+			char buf[N_VIEW_NUM_BUF_SZ];
+			view_to_c_str(s, buf);
+			return atof(buf);
+		}
+
+		double out = double(mantissa) / pow_10[n_frac];
+		return is_neg ? -out : out;
+	}
+
+	/*
+		Function: view_to_float
+		Description: same as stof_with_strip, but for views.
+	*/
+
+	inline float view_to_float(str_view_t s)
+	{
+		return float(view_to_double(s));
+	}
+
+	/*
+		Function: next_line
+		Description: finds the beginning of the next line.
+		@param curr: pointer to the current position in a buffer
+		@param end: pointer to the end of the buffer
+		@param line_len: length of the current line without the '\n' will be written here
+		@Return: pointer to the beginning of the next line
+	*/
+
+	inline const char* next_line(const char* curr, const char* end, size_t* line_len)
+	{
+		const char* nl = static_cast<const char*>(memchr(curr, '\n', size_t(end - curr)));
+		if (nl == nullptr)
+		{
+			*line_len = size_t(end - curr);
+			return end;
+		}
+		*line_len = size_t(nl - curr);
+		return nl + 1;
+	}
+
+	/*
+		Function: get_line_chunks
+		Description: splits a buffer into n_chunks parts of roughly equal size, so that
+		each part starts at the beginning of a line.
+		@param beg: pointer to the beginning of the buffer
+		@param end: pointer to the end of the buffer
+		@param n_chunks: number of chunks
+		@Return: vector of n_chunks+1 boundaries. Chunk i is [out[i], out[i+1]).
+		Some chunks may be empty if the buffer has fewer lines than n_chunks.
+	*/
+
+	inline std::vector<const char*> get_line_chunks(const char* beg, const char* end, 
+		size_t n_chunks)
+	{
+		std::vector<const char*> out = {beg};
+		size_t sz = size_t(end - beg);
+		for (size_t i = 1; i < n_chunks; i++)
+		{
+			const char* curr = beg + sz / n_chunks * i;
+			if (curr < out.back())
+			{
+				curr = out.back();
+			}
+			if (curr != beg && curr < end && curr[-1] != '\n')
+			{
+				size_t tmp;
+				curr = next_line(curr, end, &tmp);
+			}
+			out.push_back(curr);
+		}
+		out.push_back(end);
+
+		return out;
+	}
+
 	/*
 		Function: normalize_rnw_id
 		Description:
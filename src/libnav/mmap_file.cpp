@@ -0,0 +1,164 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of member functions for MappedFile class.
+*/
+
+#include "libnav/mmap_file.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace libnav
+{
+	bool get_file_stamp(std::string path, file_stamp_t* out)
+	{
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA attr;
+		if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attr))
+		{
+			return false;
+		}
+		out->size = (uint64_t(attr.nFileSizeHigh) << 32) | uint64_t(attr.nFileSizeLow);
+		// 100ns intervals
+		out->mtime = int64_t((uint64_t(attr.ftLastWriteTime.dwHighDateTime) << 32) | 
+			uint64_t(attr.ftLastWriteTime.dwLowDateTime));
+#else
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+		{
+			return false;
+		}
+		out->size = uint64_t(st.st_size);
+		// Nanoseconds where they are available, seconds otherwise
+#if defined(__linux__)
+		out->mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + int64_t(st.st_mtim.tv_nsec);
+#elif defined(__APPLE__)
+		out->mtime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + 
+			int64_t(st.st_mtimespec.tv_nsec);
+#else
+		out->mtime = int64_t(st.st_mtime);
+#endif
+#endif
+		return true;
+	}
+
+	MappedFile::MappedFile(std::string path)
+	{
+		f_open = false;
+		map_ptr = nullptr;
+		map_sz = 0;
+
+#ifdef _WIN32
+		map_handle = nullptr;
+		file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+		{
+			file_handle = nullptr;
+			return;
+		}
+
+		LARGE_INTEGER f_sz;
+		if (!GetFileSizeEx(file_handle, &f_sz))
+		{
+			return;
+		}
+		map_sz = size_t(f_sz.QuadPart);
+		if (map_sz == 0)
+		{
+			f_open = true;
+			return;
+		}
+
+		map_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (map_handle == nullptr)
+		{
+			map_sz = 0;
+			return;
+		}
+		map_ptr = static_cast<const char*>(MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0));
+		if (map_ptr == nullptr)
+		{
+			map_sz = 0;
+			return;
+		}
+#else
+		fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		{
+			return;
+		}
+		map_sz = size_t(st.st_size);
+		if (map_sz == 0)
+		{
+			f_open = true;
+			return;
+		}
+
+		void* tmp = mmap(nullptr, map_sz, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (tmp == MAP_FAILED)
+		{
+			map_sz = 0;
+			return;
+		}
+		map_ptr = static_cast<const char*>(tmp);
+		// The data bases are always read front to back
+		madvise(tmp, map_sz, MADV_SEQUENTIAL);
+#endif
+		f_open = true;
+	}
+
+	bool MappedFile::is_open()
+	{
+		return f_open;
+	}
+
+	const char* MappedFile::data()
+	{
+		return map_ptr;
+	}
+
+	size_t MappedFile::size()
+	{
+		return map_sz;
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (map_ptr != nullptr)
+			UnmapViewOfFile(map_ptr);
+		if (map_handle != nullptr)
+			CloseHandle(map_handle);
+		if (file_handle != nullptr)
+			CloseHandle(file_handle);
+#else
+		if (map_ptr != nullptr)
+			munmap(const_cast<char*>(map_ptr), map_sz);
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+}; // namespace libnav
@@ -10,7 +10,6 @@
 */
 
 #include "libnav/navaid_db.hpp"
-#include <assert.h>
 
 
 namespace libnav
@@ -133,13 +132,15 @@ namespace libnav
 	std::string waypoint_t::get_awy_id()
 	{
 		navaid_type_t xp_type = libnav_to_xp_fix_type(data.type);
-		return id + "_" + data.country_code + "_" + std::to_string(int(xp_type));
+		return id + "_" + get_code_str(data.country_code) + "_" + 
+			std::to_string(int(xp_type));
 	}
 
 	std::string waypoint_t::get_hold_id()
 	{
 		navaid_type_t xp_type = libnav_to_xp_fix_type(data.type);
-		return id + "_" + data.country_code + "_" + data.area_code + "_" + 
+		return id + "_" + get_code_str(data.country_code) + "_" + 
+			get_code_str(data.area_code) + "_" + 
 			std::to_string(int(xp_type));
 	}
 
@@ -154,7 +155,16 @@ namespace libnav
 	}
 
 
-	wpt_line_t::wpt_line_t(std::string& s, int db_version)
+	inline code_id_t intern_line_code(strutils::str_view_t s, LocalCodeTable* codes)
+	{
+		if(codes != nullptr)
+			return codes->intern(s.ptr, s.len);
+		return intern_code(s.ptr, s.len);
+	}
+
+
+	wpt_line_t::wpt_line_t(const char* s, size_t len, int db_version, 
+		LocalCodeTable* codes)
 	{
 		data.is_parsed = false;
         data.is_airac = false;
@@ -166,85 +176,91 @@ namespace libnav
 			n_col_norml = N_FIX_COL_NORML_XP11;
 		}
 
-		std::vector<std::string> s_split = strutils::str_split(s, ' ', 
-			n_col_norml-1);
+		strutils::str_view_t s_split[N_FIX_COL_NORML_XP12];
+		int n_cols = int(strutils::str_split_view(s, len, s_split, n_col_norml-1));
 
-        if(int(s_split.size()) == n_col_norml && 
-			s_split[3] == "data" && s_split[4] == "cycle")
+        if(n_cols == n_col_norml && s_split[3] == "data" && s_split[4] == "cycle")
         {
             data.is_parsed = true;
             data.is_airac = true;
-			data.db_version = strutils::stoi_with_strip(s_split[0]);
-            data.airac_cycle = strutils::stoi_with_strip(s_split[AIRAC_CYCLE_WORD-1]);
+			data.db_version = strutils::view_to_int(s_split[0]);
+            data.airac_cycle = strutils::view_to_int(s_split[AIRAC_CYCLE_WORD-1]);
         }
-        else if(int(s_split.size()) == n_col_norml)
+        else if(n_cols == n_col_norml)
         {
             data.is_parsed = true;
 			wpt.data.type = NavaidType::WAYPOINT;
-			wpt.data.pos.lat_rad = double(strutils::stof_with_strip(s_split[0])) 
+			wpt.data.pos.lat_rad = double(strutils::view_to_float(s_split[0])) 
 				* geo::DEG_TO_RAD;
-			wpt.data.pos.lon_rad = double(strutils::stof_with_strip(s_split[1])) 
+			wpt.data.pos.lon_rad = double(strutils::view_to_float(s_split[1])) 
 				* geo::DEG_TO_RAD;
-			wpt.id = s_split[2];
-			wpt.data.area_code = s_split[3];
-			wpt.data.country_code = s_split[4];
-			wpt.data.arinc_type = uint32_t(strutils::stoi_with_strip(s_split[5]));
+			wpt.data.store_nvec();
+			wpt.id.assign(s_split[2].ptr, s_split[2].len);
+			wpt.data.area_code = intern_line_code(s_split[3], codes);
+			wpt.data.country_code = intern_line_code(s_split[4], codes);
+			wpt.data.arinc_type = uint32_t(strutils::view_to_int(s_split[5]));
 			if(db_version >= XP12_DB_VERSION)
             	desc = s_split[6];
 			else
 				// No spoken name field exists in xp11, so we assume it's the same as the id
-				desc = wpt.id;  
+				desc = s_split[2];
         }
-        else if(s_split.size() && s_split[0] == "99")
+        else if(n_cols && s_split[0] == "99")
         {
             data.is_parsed = true;
             data.is_last = true;
         }
 	}
 
-	navaid_line_t::navaid_line_t(std::string& s)
+	wpt_line_t::wpt_line_t(std::string& s, int db_version): 
+		wpt_line_t(s.c_str(), s.length(), db_version) {}
+
+	navaid_line_t::navaid_line_t(const char* s, size_t len, LocalCodeTable* codes)
 	{
 		data.is_parsed = false;
         data.is_airac = false;
         data.is_last = false;
 
-		std::vector<std::string> s_split = strutils::str_split(s, ' ', 
-			N_NAVAID_COL_NORML-1);
+		strutils::str_view_t s_split[N_NAVAID_COL_NORML];
+		int n_cols = int(strutils::str_split_view(s, len, s_split, 
+			N_NAVAID_COL_NORML-1));
 
-        if(int(s_split.size()) == N_NAVAID_COL_NORML && 
-			s_split[3] == "data" && s_split[4] == "cycle")
+        if(n_cols == N_NAVAID_COL_NORML && s_split[3] == "data" && s_split[4] == "cycle")
         {
             data.is_parsed = true;
             data.is_airac = true;
-			data.db_version = strutils::stoi_with_strip(s_split[0]);
-            data.airac_cycle = strutils::stoi_with_strip(s_split[AIRAC_CYCLE_WORD-1]);
+			data.db_version = strutils::view_to_int(s_split[0]);
+            data.airac_cycle = strutils::view_to_int(s_split[AIRAC_CYCLE_WORD-1]);
         }
-        else if(int(s_split.size()) == N_NAVAID_COL_NORML)
+        else if(n_cols == N_NAVAID_COL_NORML)
         {
             data.is_parsed = true;
-			navaid_type_t xp_type = navaid_type_t(strutils::stoi_with_strip(
-					s_split[0]));
+			navaid_type_t xp_type = navaid_type_t(strutils::view_to_int(s_split[0]));
 			wpt.data.type = xp_type_to_libnav(xp_type);
-			wpt.data.pos.lat_rad = double(strutils::stof_with_strip(s_split[1])) 
+			wpt.data.pos.lat_rad = double(strutils::view_to_float(s_split[1])) 
 				* geo::DEG_TO_RAD;
-			wpt.data.pos.lon_rad = double(strutils::stof_with_strip(s_split[2])) 
+			wpt.data.pos.lon_rad = double(strutils::view_to_float(s_split[2])) 
 				* geo::DEG_TO_RAD;
-			navaid.elev_ft = double(strutils::stof_with_strip(s_split[3]));
-			navaid.freq = double(strutils::stof_with_strip(s_split[4]));
-			navaid.max_recv = uint16_t(strutils::stoi_with_strip(s_split[5]));
-			navaid.mag_var = double(strutils::stof_with_strip(s_split[6]));
-			wpt.id = s_split[7];
-			wpt.data.area_code = s_split[8];
-			wpt.data.country_code = s_split[9];
+			wpt.data.store_nvec();
+			navaid.elev_ft = double(strutils::view_to_float(s_split[3]));
+			navaid.freq = double(strutils::view_to_float(s_split[4]));
+			navaid.max_recv = uint16_t(strutils::view_to_int(s_split[5]));
+			navaid.mag_var = double(strutils::view_to_float(s_split[6]));
+			wpt.id.assign(s_split[7].ptr, s_split[7].len);
+			wpt.data.area_code = intern_line_code(s_split[8], codes);
+			wpt.data.country_code = intern_line_code(s_split[9], codes);
             desc = s_split[10];
         }
-        else if(s_split.size() && s_split[0] == "99")
+        else if(n_cols && s_split[0] == "99")
         {
             data.is_parsed = true;
             data.is_last = true;
         }
 	}
 
+	navaid_line_t::navaid_line_t(std::string& s): 
+		navaid_line_t(s.c_str(), s.length()) {}
+
 
 	bool default_navaid_filter(waypoint_t in, void* ref)
 	{
@@ -254,46 +270,97 @@ namespace libnav
 	}
 
 
-	bool WaypointEntryCompare::operator()(waypoint_entry_t w1, waypoint_entry_t w2)
+	// navaid_merge_key_t definitions:
+
+	bool navaid_merge_key_t::operator==(const navaid_merge_key_t& other) const
+	{
+		return freq_bits == other.freq_bits && lat_cell == other.lat_cell && 
+			lon_cell == other.lon_cell && id == other.id;
+	}
+
+	size_t navaid_merge_key_hash_t::operator()(const navaid_merge_key_t& key) const
 	{
-		double d1 = w1.pos.get_gc_dist_nm(ac_pos);
-		double d2 = w2.pos.get_gc_dist_nm(ac_pos);
-		return d1 < d2;
+		size_t h = std::hash<std::string>()(key.id);
+		h = h * 31 + std::hash<uint64_t>()(key.freq_bits);
+		h = h * 31 + std::hash<int64_t>()(key.lat_cell);
+		h = h * 31 + std::hash<int64_t>()(key.lon_cell);
+		return h;
 	}
 
-	bool WaypointCompare::operator()(waypoint_t w1, waypoint_t w2)
+	bool WaypointEntryCompare::operator()(const waypoint_entry_t& w1, 
+		const waypoint_entry_t& w2)
 	{
-		double d1 = w1.data.pos.get_gc_dist_nm(ac_pos);
-		double d2 = w2.data.pos.get_gc_dist_nm(ac_pos);
-		return d1 < d2;
+		geo::nvec ac_nv = ac_pos.get_nvec();
+		return ac_nv.get_chord_sq(w1.get_nvec()) < ac_nv.get_chord_sq(w2.get_nvec());
 	}
 
-	NavaidDB::NavaidDB(std::string wpt_path, std::string navaid_path)
+	bool WaypointCompare::operator()(const waypoint_t& w1, const waypoint_t& w2)
+	{
+		geo::nvec ac_nv = ac_pos.get_nvec();
+		return ac_nv.get_chord_sq(w1.data.get_nvec()) < 
+			ac_nv.get_chord_sq(w2.data.get_nvec());
+	}
+
+	NavaidDB::NavaidDB(std::string wpt_path, std::string navaid_path, size_t n_load_thr)
 	{
 		// Pre-defined stuff
 
 		err_code = DbErr::ERR_NONE;
 
+		grid_built = false;
+		n_loaders_done = 0;
+		frozen = false;
+
+		n_load_threads = n_load_thr;
+		if(n_load_threads == 0)
+		{
+			n_load_threads = std::max(size_t(std::thread::hardware_concurrency()), 
+				size_t(1));
+		}
+
 		// Paths
 
 		sim_wpt_db_path = wpt_path;
 		sim_navaid_db_path = navaid_path;
 
 
-		navaid_entries = new navaid_entry_t[NAVAID_ENTRY_CACHE_SZ];
-		n_navaid_entries = 0;
+		wpt_task = std::async(std::launch::async, [](NavaidDB* db) -> 
+			DbErr {
+				DbErr err = db->load_waypoints();
+				db->on_loader_done();
+				return err;
+			}, this);
+		navaid_task = std::async(std::launch::async, [](NavaidDB* db) -> 
+			DbErr {
+				DbErr err = db->load_navaids();
+				db->on_loader_done();
+				return err;
+			}, this);
+	}
 
-		if(navaid_entries == nullptr)
-		{
-			err_code = DbErr::BAD_ALLOC;
-		}
-		else
-		{
-			wpt_task = std::async(std::launch::async, [](NavaidDB* db) -> 
-				DbErr {return db->load_waypoints(); }, this);
-			navaid_task = std::async(std::launch::async, [](NavaidDB* db) -> 
-				DbErr {return db->load_navaids(); }, this);
-		}
+	NavaidDB::NavaidDB(std::string snap_path)
+	{
+		err_code = DbErr::ERR_NONE;
+
+		wpt_airac_cycle = 0;
+		wpt_db_version = 0;
+		navaid_airac_cycle = 0;
+		navaid_db_version = 0;
+		n_load_threads = 1;
+		grid_built = false;
+		n_loaders_done = 0;
+		frozen = false;
+
+		DbErr snap_err = load_snapshot(snap_path);
+		freeze();
+
+		// The snapshot is loaded synchronously, so both tasks are already done.
+		std::promise<DbErr> wpt_res;
+		std::promise<DbErr> navaid_res;
+		wpt_res.set_value(snap_err);
+		navaid_res.set_value(snap_err);
+		wpt_task = wpt_res.get_future();
+		navaid_task = navaid_res.get_future();
 	}
 
 	// Public member functions:
@@ -328,10 +395,130 @@ namespace libnav
 		return navaid_db_version;
 	}
 
+	size_t NavaidDB::get_in_radius(geo::point p, double dist_nm, NavaidType type,
+		std::vector<waypoint_t>* out)
+	{
+		build_grid();
+
+		std::pair<NavaidDB*, NavaidType> filt_ref = std::make_pair(this, type);
+		std::vector<geo_grid_res_t> found;
+		wpt_grid.get_in_radius(p, dist_nm, &found, grid_type_filter, &filt_ref);
+		for (size_t i = 0; i < found.size(); i++)
+		{
+			out->push_back({*grid_ids[found[i].idx], *grid_entries[found[i].idx]});
+		}
+
+		return found.size();
+	}
+
+	size_t NavaidDB::get_k_nearest(geo::point p, size_t k, NavaidType type,
+		std::vector<waypoint_t>* out)
+	{
+		build_grid();
+
+		std::pair<NavaidDB*, NavaidType> filt_ref = std::make_pair(this, type);
+		std::vector<geo_grid_res_t> found;
+		wpt_grid.get_k_nearest(p, k, &found, grid_type_filter, &filt_ref);
+		for (size_t i = 0; i < found.size(); i++)
+		{
+			out->push_back({*grid_ids[found[i].idx], *grid_entries[found[i].idx]});
+		}
+
+		return found.size();
+	}
+
+	DbErr NavaidDB::save_snapshot(std::string path)
+	{
+		if(wpt_task.valid())
+			wpt_task.wait();
+		if(navaid_task.valid())
+			navaid_task.wait();
+
+		navaid_snap_hdr_t hdr;
+		memset(&hdr, 0, sizeof(navaid_snap_hdr_t));
+		memcpy(hdr.magic, NAVAID_SNAP_MAGIC, NAVAID_SNAP_MAGIC_SZ);
+		hdr.version = NAVAID_SNAP_VERSION;
+		hdr.byte_order = NAVAID_SNAP_BYTE_ORDER;
+		hdr.wpt_airac_cycle = int32_t(wpt_airac_cycle);
+		hdr.wpt_db_version = int32_t(wpt_db_version);
+		hdr.navaid_airac_cycle = int32_t(navaid_airac_cycle);
+		hdr.navaid_db_version = int32_t(navaid_db_version);
+
+		std::string str_tbl;
+		std::vector<navaid_snap_navaid_t> navaids(navaid_entries.size());
+		std::vector<navaid_snap_wpt_t> wpts;
+
+		for (size_t i = 0; i < navaids.size(); i++)
+		{
+			memset(&navaids[i], 0, sizeof(navaid_snap_navaid_t));
+			navaids[i].elev_ft = navaid_entries[i].elev_ft;
+			navaids[i].freq = navaid_entries[i].freq;
+			navaids[i].mag_var = navaid_entries[i].mag_var;
+			navaids[i].max_recv = navaid_entries[i].max_recv;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(wpt_db_mutex);
+			std::lock_guard<std::mutex> desc_lock(desc_mutex);
+			for (auto& it: wpt_cache)
+			{
+				navaid_snap_str_t id = add_snap_str(str_tbl, it.first);
+				for (size_t i = 0; i < it.second.size(); i++)
+				{
+					waypoint_entry_t& curr = it.second[i];
+					navaid_snap_wpt_t tmp;
+					memset(&tmp, 0, sizeof(navaid_snap_wpt_t));
+					tmp.id = id;
+					tmp.area_code = add_snap_str(str_tbl, get_code_str(curr.area_code));
+					tmp.country_code = add_snap_str(str_tbl, 
+						get_code_str(curr.country_code));
+					tmp.desc = add_snap_str(str_tbl, desc_pool.c_str() + curr.desc_offset);
+					tmp.type = uint32_t(curr.type);
+					tmp.arinc_type = curr.arinc_type;
+					tmp.lat_rad = curr.pos.lat_rad;
+					tmp.lon_rad = curr.pos.lon_rad;
+					tmp.navaid_idx = NAVAID_SNAP_NO_NAVAID;
+					if(curr.navaid != nullptr)
+					{
+						tmp.navaid_idx = uint64_t(navaid_entries.get_idx(curr.navaid));
+					}
+					wpts.push_back(tmp);
+				}
+			}
+		}
+
+		if(str_tbl.size() > UINT32_MAX)
+		{
+			return DbErr::DATA_BASE_ERROR;
+		}
+
+		hdr.n_navaids = navaids.size();
+		hdr.n_wpts = wpts.size();
+		hdr.str_sz = str_tbl.size();
+
+		std::ofstream out(path, std::ofstream::binary | std::ofstream::trunc);
+		if(!out.is_open())
+		{
+			return DbErr::FILE_NOT_FOUND;
+		}
+		out.write(reinterpret_cast<const char*>(&hdr), sizeof(navaid_snap_hdr_t));
+		out.write(reinterpret_cast<const char*>(navaids.data()), 
+			std::streamsize(navaids.size() * sizeof(navaid_snap_navaid_t)));
+		out.write(reinterpret_cast<const char*>(wpts.data()), 
+			std::streamsize(wpts.size() * sizeof(navaid_snap_wpt_t)));
+		out.write(str_tbl.data(), std::streamsize(str_tbl.size()));
+		out.close();
+
+		if(out.fail())
+		{
+			return DbErr::FILE_NOT_FOUND;
+		}
+		return DbErr::SUCCESS;
+	}
+
 	void NavaidDB::reset()
 	{
-		delete[] navaid_entries;
-		n_navaid_entries = 0;
+		navaid_entries.clear();
 	}
 
 	NavaidDB::~NavaidDB()
@@ -341,85 +528,158 @@ namespace libnav
 
 	DbErr NavaidDB::load_waypoints()
 	{
-		std::ifstream file(sim_wpt_db_path);
-		if (file.is_open())
+		if (is_frozen())
 		{
-			DbErr out_code = DbErr::SUCCESS;
-			std::string line;
-			int i = 1;
-			wpt_db_version = 0;
-			while (getline(file, line))
-			{
-				wpt_line_t fix_line(line, wpt_db_version);
-				if (i > N_EARTH_LINES_IGNORE && fix_line.data.is_parsed 
-					&& !fix_line.data.is_last)
-				{
-					std::string unique_ident = get_fix_unique_ident(fix_line.wpt);
+			return DbErr::DATA_BASE_ERROR;
+		}
 
-					add_to_map_with_mutex(unique_ident, fix_line.desc, 
-						wpt_desc_mutex, wpt_desc_db);
-					add_to_wpt_cache(fix_line.wpt);
-				}
-				else if(fix_line.data.is_airac)
-				{
-					wpt_airac_cycle = fix_line.data.airac_cycle;
-					wpt_db_version = fix_line.data.db_version;
-				}
-				else if(fix_line.data.is_last)
-				{
-					break;
-				}
-				else if(i > N_EARTH_LINES_IGNORE && !fix_line.data.is_parsed)
-				{
-					out_code = DbErr::PARTIAL_LOAD;
-				}
-				i++;
+		MappedFile file(sim_wpt_db_path);
+		if (!file.is_open())
+		{
+			return DbErr::FILE_NOT_FOUND;
+		}
+
+		const char* curr = file.data();
+		const char* end = curr + file.size();
+		wpt_db_version = 0;
+		// The header is parsed before the rest of the file is split into chunks
+		// because the number of columns depends on the data base version.
+		for (int i = 1; i <= N_EARTH_LINES_IGNORE && curr < end; i++)
+		{
+			size_t line_len;
+			const char* line = curr;
+			curr = strutils::next_line(curr, end, &line_len);
+
+			wpt_line_t fix_line(line, line_len, wpt_db_version);
+			if(fix_line.data.is_airac)
+			{
+				wpt_airac_cycle = fix_line.data.airac_cycle;
+				wpt_db_version = fix_line.data.db_version;
 			}
-			file.close();
-			return out_code;
+			else if(fix_line.data.is_last)
+			{
+				return DbErr::SUCCESS;
+			}
+		}
+
+		std::vector<const char*> chunks = strutils::get_line_chunks(curr, end, 
+			n_load_threads);
+		std::vector<wpt_shard_t> shards(n_load_threads);
+		std::vector<std::future<void>> tasks;
+		for (size_t i = 1; i < n_load_threads; i++)
+		{
+			tasks.push_back(std::async(std::launch::async, load_wpt_chunk, chunks[i], 
+				chunks[i+1], wpt_db_version, &shards[i]));
+		}
+		load_wpt_chunk(chunks[0], chunks[1], wpt_db_version, &shards[0]);
+		for (size_t i = 0; i < tasks.size(); i++)
+		{
+			tasks[i].get();
+		}
+
+		// Shards are merged in file order so that the result doesn't depend on
+		// the number of threads.
+		DbErr out_code = DbErr::SUCCESS;
+		merge_desc_pool(shards[0].wpts, shards[0].desc_pool, &shards[0].codes);
+		for (size_t i = 1; i < n_load_threads && !shards[0].is_last; i++)
+		{
+			shards[0].is_partial = shards[0].is_partial || shards[i].is_partial;
+			shards[0].is_last = shards[i].is_last;
+			merge_desc_pool(shards[i].wpts, shards[i].desc_pool, &shards[i].codes);
+			append_wpt_db(shards[0].wpts, shards[i].wpts);
+		}
+		if (shards[0].is_partial)
+		{
+			out_code = DbErr::PARTIAL_LOAD;
 		}
-		return DbErr::FILE_NOT_FOUND;
+
+		merge_to_wpt_cache(shards[0].wpts);
+
+		return out_code;
 	}
 
 	DbErr NavaidDB::load_navaids()
 	{
-		std::ifstream file(sim_navaid_db_path);
-		if (file.is_open())
+		if (is_frozen())
+		{
+			return DbErr::DATA_BASE_ERROR;
+		}
+
+		MappedFile file(sim_navaid_db_path);
+		if (!file.is_open())
 		{
-			DbErr out_code = DbErr::SUCCESS;
-			std::string line;
-			int i = 1;
-			while (getline(file, line))
+			return DbErr::FILE_NOT_FOUND;
+		}
+
+		const char* curr = file.data();
+		const char* end = curr + file.size();
+		for (int i = 1; i <= N_EARTH_LINES_IGNORE && curr < end; i++)
+		{
+			size_t line_len;
+			const char* line = curr;
+			curr = strutils::next_line(curr, end, &line_len);
+
+			navaid_line_t navaid_line(line, line_len);
+			if(navaid_line.data.is_airac)
 			{
-				navaid_line_t navaid_line(line);
-				if (i > N_EARTH_LINES_IGNORE && navaid_line.data.is_parsed 
-					&& !navaid_line.data.is_last)
-				{
-					std::string unique_ident = get_fix_unique_ident(navaid_line.wpt);
+				navaid_airac_cycle = navaid_line.data.airac_cycle;
+				navaid_db_version = navaid_line.data.db_version;
+			}
+			else if(navaid_line.data.is_last)
+			{
+				return DbErr::SUCCESS;
+			}
+		}
 
-					add_to_map_with_mutex(unique_ident, navaid_line.desc, 
-						navaid_desc_mutex, navaid_desc_db);
-					add_to_navaid_cache(navaid_line.wpt, navaid_line.navaid);
-				}
-				else if(navaid_line.data.is_airac)
-				{
-					navaid_airac_cycle = navaid_line.data.airac_cycle;
-					navaid_db_version = navaid_line.data.db_version;
-				}
-				else if (navaid_line.data.is_last)
-				{
-					break;
-				}
-				else if(i > N_EARTH_LINES_IGNORE && !navaid_line.data.is_parsed)
-				{
-					out_code = DbErr::PARTIAL_LOAD;
-				}
-				i++;
+		std::vector<const char*> chunks = strutils::get_line_chunks(curr, end, 
+			n_load_threads);
+		std::vector<navaid_shard_t> shards(n_load_threads);
+		std::vector<std::future<void>> tasks;
+		for (size_t i = 1; i < n_load_threads; i++)
+		{
+			tasks.push_back(std::async(std::launch::async, load_navaid_chunk, chunks[i], 
+				chunks[i+1], &shards[i]));
+		}
+		load_navaid_chunk(chunks[0], chunks[1], &shards[0]);
+		for (size_t i = 0; i < tasks.size(); i++)
+		{
+			tasks[i].get();
+		}
+
+		// Colocated navaids are merged in file order, so this part stays sequential.
+		// It only touches loader-local maps, though.
+		DbErr out_code = DbErr::SUCCESS;
+		wpt_db_t navaids;
+		std::string desc_pool(1, '\0');
+		navaid_merge_idx_t merge_idx;
+		for (size_t i = 0; i < n_load_threads; i++)
+		{
+			if (shards[i].is_partial)
+			{
+				out_code = DbErr::PARTIAL_LOAD;
+			}
+
+			std::vector<navaid_line_t>& lines = shards[i].lines;
+			std::vector<code_id_t> code_ids = shards[i].codes.get_global_ids();
+			for (size_t j = 0; j < lines.size(); j++)
+			{
+				lines[j].wpt.data.area_code = code_ids[lines[j].wpt.data.area_code];
+				lines[j].wpt.data.country_code = code_ids[lines[j].wpt.data.country_code];
+				lines[j].wpt.data.desc_offset = add_desc(desc_pool, lines[j].desc.ptr, 
+					lines[j].desc.len);
+				add_to_navaid_cache(navaids, merge_idx, lines[j].wpt, lines[j].navaid);
+			}
+
+			if (shards[i].is_last)
+			{
+				break;
 			}
-			file.close();
-			return out_code;
 		}
-		return DbErr::FILE_NOT_FOUND;
+
+		merge_desc_pool(navaids, desc_pool);
+		merge_to_wpt_cache(navaids);
+
+		return out_code;
 	}
 
 	const wpt_db_t& NavaidDB::get_db()
@@ -427,20 +687,32 @@ namespace libnav
 		return wpt_cache;
 	}
 
-	bool NavaidDB::is_wpt(std::string id) 
+	bool NavaidDB::is_frozen()
 	{
-		std::lock_guard<std::mutex> lock(wpt_db_mutex);
+		return frozen.load(std::memory_order_acquire);
+	}
+
+	bool NavaidDB::is_wpt(const std::string& id) 
+	{
+		std::unique_lock<std::mutex> lock(wpt_db_mutex, std::defer_lock);
+		if (!is_frozen())
+			lock.lock();
+
 		return wpt_cache.find(id) != wpt_cache.end();
 	}
 
-	bool NavaidDB::is_navaid_of_type(std::string id, NavaidType type)
+	bool NavaidDB::is_navaid_of_type(const std::string& id, NavaidType type)
 	{
-		if (is_wpt(id))
+		std::unique_lock<std::mutex> lock(wpt_db_mutex, std::defer_lock);
+		if (!is_frozen())
+			lock.lock();
+
+		auto it = wpt_cache.find(id);
+		if (it != wpt_cache.end())
 		{
-			std::lock_guard<std::mutex> lock(wpt_db_mutex);
-			for(size_t i = 0; i < wpt_cache[id].size(); i++)
+			for(size_t i = 0; i < it->second.size(); i++)
 			{
-				NavaidType curr_type = wpt_cache[id][i].type;
+				NavaidType curr_type = it->second[i].type;
 				if((static_cast<int>(curr_type) & static_cast<int>(type)) == 
 					static_cast<int>(curr_type))
 				{
@@ -451,34 +723,34 @@ namespace libnav
 		return false;
 	}
 
-	size_t NavaidDB::get_wpt_data(std::string& id, std::vector<waypoint_entry_t>* out, 
-		std::string area_code, std::string country_code, NavaidType type, 
+	size_t NavaidDB::get_wpt_data(const std::string& id, std::vector<waypoint_entry_t>* out, 
+		const std::string& area_code, const std::string& country_code, NavaidType type, 
 		navaid_filter_t filt_func, void* ref)
 	{
-		if (is_wpt(id))
+		code_id_t area_id;
+		code_id_t country_id;
+		if(!get_code_filt(area_code, country_code, &area_id, &country_id))
 		{
-			std::lock_guard<std::mutex> lock(wpt_db_mutex);
-			std::vector<waypoint_entry_t>* waypoints = &wpt_cache.at(id);
-			size_t n_waypoints = waypoints->size();
-			for (size_t i = 0; i < n_waypoints; i++)
+			return out->size();
+		}
+		// The default filter accepts everything, so there is no need to 
+		// build a waypoint_t for it.
+		bool use_filt = filt_func != default_navaid_filter;
+
+		std::unique_lock<std::mutex> lock(wpt_db_mutex, std::defer_lock);
+		if (!is_frozen())
+			lock.lock();
+
+		auto it = wpt_cache.find(id);
+		if (it != wpt_cache.end())
+		{
+			const std::vector<waypoint_entry_t>& waypoints = it->second;
+			for (size_t i = 0; i < waypoints.size(); i++)
 			{
-				waypoint_entry_t wpt_curr = waypoints->at(i);
+				const waypoint_entry_t& wpt_curr = waypoints[i];
 
-				bool is_fine = true;
-				if(area_code != "" && wpt_curr.area_code != area_code)
-				{
-					is_fine = false;
-				}
-				if(country_code != "" && wpt_curr.country_code != country_code)
-				{
-					is_fine = false;
-				}
-				else if(type != NavaidType::NONE && 
-					(static_cast<int>(wpt_curr.type) & static_cast<int>(type)) == 0)
-				{
-					is_fine = false;
-				}
-				if(is_fine && filt_func({id, wpt_curr}, ref))
+				if(is_entry_match(wpt_curr, area_id, country_id, type) && 
+					(!use_filt || filt_func({id, wpt_curr}, ref)))
 				{
 					out->push_back(wpt_curr);
 				}
@@ -487,6 +759,83 @@ namespace libnav
 		return out->size();
 	}
 
+	const std::vector<waypoint_entry_t>* NavaidDB::find_wpt_entries(const std::string& id)
+	{
+		if (!is_frozen())
+		{
+			return nullptr;
+		}
+
+		auto it = wpt_cache.find(id);
+		if (it != wpt_cache.end())
+		{
+			return &it->second;
+		}
+		return nullptr;
+	}
+
+	size_t NavaidDB::visit_wpt_data(const std::string& id, wpt_visitor_t visitor, 
+		void* ref, const std::string& area_code, const std::string& country_code, 
+		NavaidType type)
+	{
+		code_id_t area_id;
+		code_id_t country_id;
+		if(!get_code_filt(area_code, country_code, &area_id, &country_id))
+		{
+			return 0;
+		}
+
+		std::unique_lock<std::mutex> lock(wpt_db_mutex, std::defer_lock);
+		if (!is_frozen())
+			lock.lock();
+
+		size_t n_visited = 0;
+		auto it = wpt_cache.find(id);
+		if (it != wpt_cache.end())
+		{
+			const std::vector<waypoint_entry_t>& waypoints = it->second;
+			for (size_t i = 0; i < waypoints.size(); i++)
+			{
+				if(is_entry_match(waypoints[i], area_id, country_id, type))
+				{
+					n_visited++;
+					if(!visitor(it->first, waypoints[i], ref))
+					{
+						break;
+					}
+				}
+			}
+		}
+		return n_visited;
+	}
+
+	bool NavaidDB::get_wpt_nearest(const std::string& id, geo::point pos, 
+		waypoint_entry_t* out, NavaidType type)
+	{
+		struct nearest_ref_t
+		{
+			geo::nvec pos_nv;
+			double min_chord_sq;
+			waypoint_entry_t* out;
+		};
+
+		nearest_ref_t nearest = {pos.get_nvec(), -1, out};
+		auto visitor = [](const std::string&, const waypoint_entry_t& entry, 
+			void* ref) -> bool {
+				nearest_ref_t* curr = reinterpret_cast<nearest_ref_t*>(ref);
+				double chord_sq = curr->pos_nv.get_chord_sq(entry.get_nvec());
+				if(curr->min_chord_sq < 0 || chord_sq < curr->min_chord_sq)
+				{
+					curr->min_chord_sq = chord_sq;
+					*curr->out = entry;
+				}
+				return true;
+			};
+		visit_wpt_data(id, visitor, &nearest, "", "", type);
+
+		return nearest.min_chord_sq >= 0;
+	}
+
 	size_t NavaidDB::get_wpt_by_awy_str(std::string& awy_str, 
 		std::vector<waypoint_entry_t>* out)
 	{
@@ -509,75 +858,154 @@ namespace libnav
 
 	std::string NavaidDB::get_fix_desc(waypoint_t& fix)
 	{
-		std::string unique_ident = get_fix_unique_ident(fix);
-		if(fix.data.navaid != nullptr)
+		uint32_t desc_offset = fix.data.desc_offset;
+		if(desc_offset == 0)
+		{
+			// The waypoint wasn't created by this data base. Use the last entry
+			// with the same id, codes and kind.
+			std::unique_lock<std::mutex> lock(wpt_db_mutex, std::defer_lock);
+			if (!is_frozen())
+				lock.lock();
+
+			auto it = wpt_cache.find(fix.id);
+			if(it != wpt_cache.end())
+			{
+				for (auto& entry: it->second)
+				{
+					if(entry.area_code == fix.data.area_code && 
+						entry.country_code == fix.data.country_code && 
+						(entry.navaid == nullptr) == (fix.data.navaid == nullptr))
+					{
+						desc_offset = entry.desc_offset;
+					}
+				}
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(desc_mutex, std::defer_lock);
+		if (!is_frozen())
+			lock.lock();
+		if(desc_offset >= desc_pool.size())
 		{
-			return get_map_val_with_mutex(unique_ident, navaid_desc_mutex, 
-				navaid_desc_db);
+			return "";
 		}
+		return desc_pool.c_str() + desc_offset;
+	}
 
-		return get_map_val_with_mutex(unique_ident, wpt_desc_mutex, wpt_desc_db);
+	const char* NavaidDB::find_fix_desc(const waypoint_entry_t& entry)
+	{
+		if(!is_frozen() || entry.desc_offset >= desc_pool.size())
+		{
+			return nullptr;
+		}
+		return desc_pool.c_str() + entry.desc_offset;
 	}
 
 	// Private member functions:
 
 	navaid_entry_t* NavaidDB::navaid_entries_add(navaid_entry_t data)
 	{
-		navaid_entries[n_navaid_entries] = data;
-		n_navaid_entries++;
-
-		assert(n_navaid_entries < NAVAID_ENTRY_CACHE_SZ);
+		return navaid_entries.add(data);
+	}
 
-		return &navaid_entries[n_navaid_entries-1];
+	void NavaidDB::merge_to_wpt_cache(wpt_db_t& src)
+	{
+		std::lock_guard<std::mutex> lock(wpt_db_mutex);
+		// Append the smaller map to the bigger one
+		if (wpt_cache.size() < src.size())
+		{
+			std::swap(wpt_cache, src);
+		}
+		append_wpt_db(wpt_cache, src);
 	}
 
-	void NavaidDB::add_to_wpt_cache(waypoint_t wpt)
+	void NavaidDB::merge_desc_pool(wpt_db_t& db, std::string& pool, 
+		const LocalCodeTable* codes)
 	{
-		// Find the navaid in the database by name.
-		if (is_wpt(wpt.id))
+		uint32_t base;
 		{
-			std::lock_guard<std::mutex> lock(wpt_db_mutex);
-			// If there is a waypoint with the same name in the database,
-			// add new entry to the vector.
-			wpt_cache.at(wpt.id).push_back(wpt.data);
+			std::lock_guard<std::mutex> lock(desc_mutex);
+			// Both pools start with the same empty string
+			base = uint32_t(desc_pool.size() - 1);
+			desc_pool.append(pool, 1, std::string::npos);
 		}
-		else
+		std::vector<code_id_t> code_ids;
+		if(codes != nullptr)
 		{
-			std::lock_guard<std::mutex> lock(wpt_db_mutex);
-			// If there is no waypoint with the same name in the database,
-			// add a vector with tmp
-			std::pair<std::string, std::vector<waypoint_entry_t>> p;
-			p = std::make_pair(wpt.id, std::vector<waypoint_entry_t>{wpt.data});
-			wpt_cache.insert(p);
+			code_ids = codes->get_global_ids();
+		}
+		for (auto& it: db)
+		{
+			for (auto& entry: it.second)
+			{
+				if(entry.desc_offset != 0)
+				{
+					entry.desc_offset += base;
+				}
+				if(codes != nullptr)
+				{
+					entry.area_code = code_ids[entry.area_code];
+					entry.country_code = code_ids[entry.country_code];
+				}
+			}
 		}
+		std::string().swap(pool);
 	}
 
-	void NavaidDB::add_to_navaid_cache(waypoint_t wpt, navaid_entry_t data)
+	void NavaidDB::add_to_navaid_cache(wpt_db_t& db, navaid_merge_idx_t& merge_idx, 
+		waypoint_t& wpt, navaid_entry_t data)
 	{
 		// Find the navaid in the database by name.
-		if (is_wpt(wpt.id))
-		{
-			// If there is a navaid with the same name in the database,
-			// add new entry to the vector.
-			bool is_colocated = false;
-			bool is_duplicate = false;
-			std::vector<waypoint_entry_t>* entries = &wpt_cache.at(wpt.id);
-			for (size_t i = 0; i < entries->size(); i++)
+		// If there is a navaid with the same name in the database,
+		// add new entry to the vector.
+		std::vector<waypoint_entry_t>& entries = db[wpt.id];
+
+		// Only navaids with the same frequency located in the neighboring cells
+		// can be equal to the new one or merged with it. Adding 0 turns -0 into 0,
+		// so that frequencies that compare equal have equal keys.
+		double freq = data.freq + 0.0;
+		navaid_merge_key_t key;
+		key.id = wpt.id;
+		memcpy(&key.freq_bits, &freq, sizeof(uint64_t));
+		int64_t lat_cell = int64_t(floor(wpt.data.pos.lat_rad / NAVAID_MERGE_CELL_RAD));
+		int64_t lon_cell = int64_t(floor(wpt.data.pos.lon_rad / NAVAID_MERGE_CELL_RAD));
+
+		// Out of all matching navaids, the one that was added first is used
+		size_t match_idx = entries.size();
+		NavaidType match_type = NavaidType::NONE;
+		for (int64_t i = -1; i <= 1; i++)
+		{
+			for (int64_t j = -1; j <= 1; j++)
 			{
-				if (entries->at(i).navaid != nullptr)
+				key.lat_cell = lat_cell + i;
+				key.lon_cell = lon_cell + j;
+				auto it = merge_idx.find(key);
+				if (it == merge_idx.end())
+				{
+					continue;
+				}
+
+				for (size_t k : it->second)
 				{
-					waypoint_entry_t tmp_wpt = entries->at(i);
+					if (k >= match_idx)
+					{
+						continue;
+					}
+					waypoint_entry_t& tmp_wpt = entries[k];
 					navaid_entry_t* tmp_navaid = tmp_wpt.navaid;
 
-					bool is_wpt_equal = !bool(memcmp(&tmp_wpt.pos, &wpt.data.pos, sizeof(geo::point)));
+					bool is_wpt_equal = !bool(memcmp(&tmp_wpt.pos, &wpt.data.pos, 
+						sizeof(geo::point)));
 					bool is_type_equal = tmp_wpt.type == wpt.data.type;
-					bool is_nav_equal = !bool(memcmp(tmp_wpt.navaid, &data, sizeof(navaid_entry_t)));
+					bool is_nav_equal = !bool(memcmp(tmp_navaid, &data, 
+						sizeof(navaid_entry_t)));
 					bool is_equal = is_wpt_equal && is_nav_equal && is_type_equal;
 
 					if (is_equal)
 					{
-						is_duplicate = true;
-						break;
+						match_idx = k;
+						match_type = tmp_wpt.type;
+						continue;
 					}
 
 					double lat_dev = abs(wpt.data.pos.lat_rad - tmp_wpt.pos.lat_rad);
@@ -587,55 +1015,371 @@ namespace libnav
 					bool is_comp = type_sum != NavaidType::NONE;
 					if (ang_dev < MAX_ANG_DEV_MERGE && is_comp && data.freq == tmp_navaid->freq)
 					{
-						entries->at(i).type = type_sum;
-						is_colocated = true;
-						break;
+						match_idx = k;
+						match_type = type_sum;
 					}
 				}
 			}
-			if (!is_colocated && !is_duplicate)
+		}
+
+		if (match_idx < entries.size())
+		{
+			// The description is taken from the last line of the merged navaids
+			entries[match_idx].type = match_type;
+			entries[match_idx].desc_offset = wpt.data.desc_offset;
+			return;
+		}
+
+		key.lat_cell = lat_cell;
+		key.lon_cell = lon_cell;
+		merge_idx[key].push_back(entries.size());
+		wpt.data.navaid = navaid_entries_add(data);
+		entries.push_back(wpt.data);
+	}
+
+	DbErr NavaidDB::load_snapshot(std::string& path)
+	{
+		MappedFile file(path);
+		if(!file.is_open())
+		{
+			return DbErr::FILE_NOT_FOUND;
+		}
+
+		navaid_snap_hdr_t hdr;
+		uint64_t f_sz = file.size();
+		if(f_sz < sizeof(navaid_snap_hdr_t))
+		{
+			return DbErr::DATA_BASE_ERROR;
+		}
+		memcpy(&hdr, file.data(), sizeof(navaid_snap_hdr_t));
+		if(memcmp(hdr.magic, NAVAID_SNAP_MAGIC, NAVAID_SNAP_MAGIC_SZ) || 
+			hdr.version != NAVAID_SNAP_VERSION || 
+			hdr.byte_order != NAVAID_SNAP_BYTE_ORDER)
+		{
+			return DbErr::DATA_BASE_ERROR;
+		}
+
+		// Check the counts one by one so that the size calculation can't overflow.
+		uint64_t sz_left = f_sz - sizeof(navaid_snap_hdr_t);
+		if(hdr.n_navaids > sz_left / sizeof(navaid_snap_navaid_t))
+			return DbErr::DATA_BASE_ERROR;
+		sz_left -= hdr.n_navaids * sizeof(navaid_snap_navaid_t);
+		if(hdr.n_wpts > sz_left / sizeof(navaid_snap_wpt_t))
+			return DbErr::DATA_BASE_ERROR;
+		sz_left -= hdr.n_wpts * sizeof(navaid_snap_wpt_t);
+		if(hdr.str_sz != sz_left)
+			return DbErr::DATA_BASE_ERROR;
+
+		const char* curr = file.data() + sizeof(navaid_snap_hdr_t);
+		const char* str_tbl = file.data() + (f_sz - hdr.str_sz);
+
+		for (uint64_t i = 0; i < hdr.n_navaids; i++)
+		{
+			navaid_snap_navaid_t tmp;
+			memcpy(&tmp, curr, sizeof(navaid_snap_navaid_t));
+			curr += sizeof(navaid_snap_navaid_t);
+
+			navaid_entry_t data;
+			memset(&data, 0, sizeof(navaid_entry_t));
+			data.elev_ft = tmp.elev_ft;
+			data.freq = tmp.freq;
+			data.mag_var = tmp.mag_var;
+			data.max_recv = tmp.max_recv;
+			navaid_entries_add(data);
+		}
+
+		wpt_db_t wpts;
+		std::string descs(1, '\0');
+		wpts.reserve(size_t(hdr.n_wpts));
+		std::vector<waypoint_entry_t>* entries = nullptr;
+		navaid_snap_str_t prev_id = {0, 0};
+		for (uint64_t i = 0; i < hdr.n_wpts; i++)
+		{
+			navaid_snap_wpt_t tmp;
+			memcpy(&tmp, curr, sizeof(navaid_snap_wpt_t));
+			curr += sizeof(navaid_snap_wpt_t);
+
+			waypoint_entry_t data;
+			std::string area_code;
+			std::string country_code;
+			std::string desc;
+			if(!get_snap_str(str_tbl, hdr.str_sz, tmp.area_code, &area_code) || 
+				!get_snap_str(str_tbl, hdr.str_sz, tmp.country_code, &country_code) || 
+				!get_snap_str(str_tbl, hdr.str_sz, tmp.desc, &desc))
+			{
+				return DbErr::DATA_BASE_ERROR;
+			}
+			data.desc_offset = add_desc(descs, desc.c_str(), desc.size());
+			data.area_code = intern_code(area_code);
+			data.country_code = intern_code(country_code);
+			data.type = NavaidType(tmp.type);
+			data.arinc_type = tmp.arinc_type;
+			data.pos.lat_rad = tmp.lat_rad;
+			data.pos.lon_rad = tmp.lon_rad;
+			data.store_nvec();
+			if(tmp.navaid_idx != NAVAID_SNAP_NO_NAVAID)
 			{
-				wpt.data.navaid = navaid_entries_add(data);
-				
-				std::lock_guard<std::mutex> lock(wpt_db_mutex);
-				entries->push_back(wpt.data);
+				if(tmp.navaid_idx >= hdr.n_navaids)
+				{
+					return DbErr::DATA_BASE_ERROR;
+				}
+				data.navaid = &navaid_entries[size_t(tmp.navaid_idx)];
 			}
+
+			// All entries with the same id reference the same string
+			if(entries == nullptr || tmp.id.offset != prev_id.offset || 
+				tmp.id.len != prev_id.len)
+			{
+				std::string id;
+				if(!get_snap_str(str_tbl, hdr.str_sz, tmp.id, &id))
+				{
+					return DbErr::DATA_BASE_ERROR;
+				}
+				entries = &wpts[id];
+				prev_id = tmp.id;
+			}
+			entries->push_back(data);
 		}
-		else
+
+		wpt_airac_cycle = hdr.wpt_airac_cycle;
+		wpt_db_version = hdr.wpt_db_version;
+		navaid_airac_cycle = hdr.navaid_airac_cycle;
+		navaid_db_version = hdr.navaid_db_version;
+
+		merge_desc_pool(wpts, descs);
+		merge_to_wpt_cache(wpts);
+
+		return DbErr::SUCCESS;
+	}
+
+	void NavaidDB::build_grid()
+	{
+		if(grid_built.load(std::memory_order_acquire))
 		{
-			// If there is no navaid with the same name in the database,
-			// add a vector with tmp
-			wpt.data.navaid = navaid_entries_add(data);
+			return;
+		}
 
-			add_to_wpt_cache(wpt);
+		std::lock_guard<std::mutex> grid_lock(grid_mutex);
+		if(grid_built.load(std::memory_order_relaxed))
+		{
+			return;
 		}
+
+		if(wpt_task.valid())
+			wpt_task.wait();
+		if(navaid_task.valid())
+			navaid_task.wait();
+
+		std::lock_guard<std::mutex> lock(wpt_db_mutex);
+		std::vector<geo::point> pts;
+		for (auto& it: wpt_cache)
+		{
+			for (size_t i = 0; i < it.second.size(); i++)
+			{
+				grid_ids.push_back(&it.first);
+				grid_entries.push_back(&it.second[i]);
+				pts.push_back(it.second[i].pos);
+			}
+		}
+		wpt_grid.build(pts);
+
+		grid_built.store(true, std::memory_order_release);
 	}
 
+	void NavaidDB::on_loader_done()
+	{
+		// Both loaders have merged their data by the time the counter reaches 2
+		if(n_loaders_done.fetch_add(1, std::memory_order_acq_rel) == 1)
+		{
+			freeze();
+		}
+	}
 
-	std::string NavaidDB::get_fix_unique_ident(waypoint_t& fix)
+	void NavaidDB::freeze()
 	{
-		return fix.id + fix.data.country_code + fix.data.area_code;
+		{
+			std::lock_guard<std::mutex> lock(wpt_db_mutex);
+			std::vector<bool> is_added;
+			for (auto& it: wpt_cache)
+			{
+				for (size_t i = 0; i < it.second.size(); i++)
+				{
+					code_id_t codes[] = {it.second[i].area_code, it.second[i].country_code};
+					for (size_t j = 0; j < 2; j++)
+					{
+						if(codes[j] >= is_added.size())
+						{
+							is_added.resize(codes[j] + 1, false);
+						}
+						if(!is_added[codes[j]])
+						{
+							is_added[codes[j]] = true;
+							db_codes[get_code_str(codes[j])] = codes[j];
+						}
+					}
+				}
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(desc_mutex);
+			desc_pool.shrink_to_fit();
+		}
+
+		frozen.store(true, std::memory_order_release);
 	}
 
-	void NavaidDB::add_to_map_with_mutex(std::string& id, std::string& desc,
-		std::mutex& mtx, std::unordered_map<std::string, std::string>& umap)
+	bool NavaidDB::find_db_code(const std::string& s, code_id_t* out)
 	{
-		std::lock_guard<std::mutex> lock(mtx);
+		if(!is_frozen())
+		{
+			return find_code(s, out);
+		}
+
+		auto it = db_codes.find(s);
+		if(it != db_codes.end())
+		{
+			*out = it->second;
+			return true;
+		}
+		return false;
+	}
 
-		umap[id] = desc;
+	bool NavaidDB::get_code_filt(const std::string& area_code, 
+		const std::string& country_code, code_id_t* area_id, code_id_t* country_id)
+	{
+		// CODE_ID_EMPTY means that the filter isn't set. Codes that aren't in the table
+		// can't match any of the entries.
+		*area_id = CODE_ID_EMPTY;
+		*country_id = CODE_ID_EMPTY;
+		return (area_code == "" || find_db_code(area_code, area_id)) && 
+			(country_code == "" || find_db_code(country_code, country_id));
 	}
 
-	std::string NavaidDB::get_map_val_with_mutex(std::string& id,
-		std::mutex& mtx, std::unordered_map<std::string, std::string>& umap)
+	bool NavaidDB::grid_type_filter(size_t idx, void* ref)
 	{
-		std::lock_guard<std::mutex> lock(mtx);
+		std::pair<NavaidDB*, NavaidType>* filt_ref = 
+			reinterpret_cast<std::pair<NavaidDB*, NavaidType>*>(ref);
+		int type = static_cast<int>(filt_ref->second);
+		int curr_type = static_cast<int>(filt_ref->first->grid_entries[idx]->type);
+
+		return type == static_cast<int>(NavaidType::NONE) || (curr_type & type) != 0;
+	}
 
-		if(umap.find(id) != umap.end())
+	bool NavaidDB::is_entry_match(const waypoint_entry_t& entry, code_id_t area_id,
+		code_id_t country_id, NavaidType type)
+	{
+		if(area_id != CODE_ID_EMPTY && entry.area_code != area_id)
 		{
-			return umap[id];
+			return false;
 		}
+		if(country_id != CODE_ID_EMPTY && entry.country_code != country_id)
+		{
+			return false;
+		}
+		return type == NavaidType::NONE || 
+			(static_cast<int>(entry.type) & static_cast<int>(type)) != 0;
+	}
 
-		return "";
+	void NavaidDB::load_wpt_chunk(const char* beg, const char* end, int db_version,
+		wpt_shard_t* out)
+	{
+		while (beg < end)
+		{
+			size_t line_len;
+			const char* line = beg;
+			beg = strutils::next_line(beg, end, &line_len);
+
+			wpt_line_t fix_line(line, line_len, db_version, &out->codes);
+			if (fix_line.data.is_parsed && !fix_line.data.is_last)
+			{
+				fix_line.wpt.data.desc_offset = add_desc(out->desc_pool, 
+					fix_line.desc.ptr, fix_line.desc.len);
+				out->wpts[fix_line.wpt.id].push_back(fix_line.wpt.data);
+			}
+			else if(fix_line.data.is_last)
+			{
+				out->is_last = true;
+				break;
+			}
+			else
+			{
+				out->is_partial = true;
+			}
+		}
+	}
+
+	void NavaidDB::load_navaid_chunk(const char* beg, const char* end, 
+		navaid_shard_t* out)
+	{
+		while (beg < end)
+		{
+			size_t line_len;
+			const char* line = beg;
+			beg = strutils::next_line(beg, end, &line_len);
+
+			navaid_line_t navaid_line(line, line_len, &out->codes);
+			if (navaid_line.data.is_parsed && !navaid_line.data.is_last)
+			{
+				out->lines.push_back(navaid_line);
+			}
+			else if(navaid_line.data.is_last)
+			{
+				out->is_last = true;
+				break;
+			}
+			else
+			{
+				out->is_partial = true;
+			}
+		}
+	}
+
+	void NavaidDB::append_wpt_db(wpt_db_t& dst, wpt_db_t& src)
+	{
+		for (auto& it: src)
+		{
+			std::vector<waypoint_entry_t>& entries = dst[it.first];
+			if (entries.empty())
+			{
+				entries = std::move(it.second);
+			}
+			else
+			{
+				entries.insert(entries.end(), it.second.begin(), it.second.end());
+			}
+		}
+	}
+
+	uint32_t NavaidDB::add_desc(std::string& pool, const char* s, size_t len)
+	{
+		if(len == 0)
+		{
+			return 0;
+		}
+		uint32_t offset = uint32_t(pool.size());
+		pool.append(s, len);
+		pool.push_back('\0');
+		return offset;
+	}
+
+	navaid_snap_str_t NavaidDB::add_snap_str(std::string& str_tbl, const std::string& s)
+	{
+		navaid_snap_str_t out;
+		out.offset = uint32_t(str_tbl.size());
+		out.len = uint32_t(s.size());
+		str_tbl.append(s);
+		return out;
+	}
+
+	bool NavaidDB::get_snap_str(const char* str_tbl, uint64_t str_sz, 
+		navaid_snap_str_t s, std::string* out)
+	{
+		if(uint64_t(s.offset) + uint64_t(s.len) > str_sz)
+		{
+			return false;
+		}
+		out->assign(str_tbl + s.offset, s.len);
+		return true;
 	}
 
 
@@ -670,20 +1414,95 @@ namespace libnav
 		}
 	}
 
-	void sort_wpt_entry_by_dist(std::vector<waypoint_entry_t>* vec, geo::point p)
+	// Writes indices of the k smallest keys to out in ascending order of keys.
+	// Equal keys are ordered by index.
+	size_t rank_by_keys(const std::vector<double>& keys, size_t k, 
+		std::vector<size_t>* out)
 	{
-		WaypointEntryCompare comp;
-		comp.ac_pos = p;
+		out->resize(keys.size());
+		for (size_t i = 0; i < out->size(); i++)
+		{
+			(*out)[i] = i;
+		}
 
-		sort(vec->begin(), vec->end(), comp);
+		auto cmp = [&keys](size_t i1, size_t i2) {
+			return keys[i1] < keys[i2] || (keys[i1] == keys[i2] && i1 < i2);
+		};
+		if(k < out->size())
+		{
+			std::partial_sort(out->begin(), out->begin() + long(k), out->end(), cmp);
+			out->resize(k);
+		}
+		else
+		{
+			std::sort(out->begin(), out->end(), cmp);
+		}
+		return out->size();
 	}
 
-	void sort_wpts_by_dist(std::vector<waypoint_t>* vec, geo::point p)
+	// Moves the items listed in order to the front of vec. The rest of the items
+	// keep their relative order.
+	template<typename T>
+	void move_to_front(std::vector<T>* vec, const std::vector<size_t>& order)
 	{
-		WaypointCompare comp;
-		comp.ac_pos = p;
+		std::vector<bool> is_moved(vec->size(), false);
+		std::vector<T> sorted;
+		sorted.reserve(vec->size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			sorted.push_back(std::move((*vec)[order[i]]));
+			is_moved[order[i]] = true;
+		}
+		for (size_t i = 0; i < vec->size(); i++)
+		{
+			if(!is_moved[i])
+			{
+				sorted.push_back(std::move((*vec)[i]));
+			}
+		}
+		*vec = std::move(sorted);
+	}
+
+	// Distances are compared as chord lengths between n-vectors, so no 
+	// trigonometry is needed for entries loaded by NavaidDB.
+
+	size_t rank_wpt_entries_by_dist(const std::vector<waypoint_entry_t>& vec, 
+		geo::point p, size_t k, std::vector<size_t>* out)
+	{
+		geo::nvec p_nv = p.get_nvec();
+		std::vector<double> keys(vec.size());
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			keys[i] = p_nv.get_chord_sq(vec[i].get_nvec());
+		}
+		return rank_by_keys(keys, k, out);
+	}
 
-		sort(vec->begin(), vec->end(), comp);
+	size_t rank_wpts_by_dist(const std::vector<waypoint_t>& vec, geo::point p, 
+		size_t k, std::vector<size_t>* out)
+	{
+		geo::nvec p_nv = p.get_nvec();
+		std::vector<double> keys(vec.size());
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			keys[i] = p_nv.get_chord_sq(vec[i].data.get_nvec());
+		}
+		return rank_by_keys(keys, k, out);
+	}
+
+	void sort_wpt_entry_by_dist(std::vector<waypoint_entry_t>* vec, geo::point p, 
+		size_t k)
+	{
+		std::vector<size_t> order;
+		rank_wpt_entries_by_dist(*vec, p, k, &order);
+		move_to_front(vec, order);
+	}
+
+	void sort_wpts_by_dist(std::vector<waypoint_t>* vec, geo::point p, size_t k)
+	{
+		std::vector<size_t> order;
+		rank_wpts_by_dist(*vec, p, k, &order);
+		move_to_front(vec, order);
 	}
 }; // namespace libnav
 
@@ -698,13 +1517,14 @@ namespace radnav_util
 
 	double get_dme_fom(double dist_nm)
 	{
-		double max_val = std::pow(0.085, 2);
-		double tmp_val = std::pow(0.00125 * dist_nm, 2);
+		double max_val = 0.085 * 0.085;
+		double tmp_val = 0.00125 * dist_nm;
+		tmp_val *= tmp_val;
 		if (max_val < tmp_val)
 		{
 			max_val = tmp_val;
 		}
-		double variance = std::pow(0.05, 2) + max_val;
+		double variance = 0.05 * 0.05 + max_val;
 		// Now convert variance to FOM(standard_deviation * 2)
 		return sqrt(variance) * 2;
 	}
@@ -717,7 +1537,9 @@ namespace radnav_util
 
 	double get_vor_fom(double dist_nm)
 	{
-		double variance = std::pow((0.0122 * dist_nm), 2) + std::pow((0.0175 * dist_nm), 2);
+		double v1 = 0.0122 * dist_nm;
+		double v2 = 0.0175 * dist_nm;
+		double variance = v1 * v1 + v2 * v2;
 		return sqrt(variance) * 2;
 	}
 
@@ -796,13 +1618,7 @@ namespace radnav_util
 		return -1;
 	}
 
-	/*
-		This function calculates the quality ratio for a navaid.
-		Navaids are sorted by this ratio to determine the best 
-		suitable candidate(s) for radio navigation.
-	*/
-
-	void navaid_t::calc_qual(geo::point3d ac_pos)
+	double get_navaid_qual(const libnav::waypoint_entry_t& data, geo::point3d ac_pos)
 	{
 		libnav::navaid_entry_t* nav_data = data.navaid;
 		if (nav_data != nullptr)
@@ -822,13 +1638,34 @@ namespace radnav_util
 					double tmp = 1 - (true_dist_nm / nav_data->max_recv);
 					if (tmp >= 0)
 					{
-						qual = tmp;
-						return;
+						return tmp;
 					}
 				}
 			}
 		}
-		qual = -1;
+		return -1;
+	}
+
+	double get_navaid_qual(const libnav::waypoint_entry_t& data, geo::point3d ac_pos,
+		const geo::nvec& ac_nv)
+	{
+		// The approximate distance never exceeds the true distance
+		if (data.navaid != nullptr && 
+			ac_nv.get_approx_dist_nm(data.get_nvec()) > data.navaid->max_recv)
+		{
+			return -1;
+		}
+		return get_navaid_qual(data, ac_pos);
+	}
+
+	void navaid_t::calc_qual(geo::point3d ac_pos)
+	{
+		qual = get_navaid_qual(data, ac_pos);
+	}
+
+	void navaid_t::calc_qual(geo::point3d ac_pos, const geo::nvec& ac_nv)
+	{
+		qual = get_navaid_qual(data, ac_pos, ac_nv);
 	}
 	
 	/*
@@ -0,0 +1,392 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of member functions for NavaidSelector and
+	NavaidTracker classes.
+*/
+
+#include "libnav/navaid_selector.hpp"
+
+
+namespace radnav_util
+{
+	double get_max_dme_recv_nm(std::shared_ptr<libnav::NavaidDB> db)
+	{
+		double max_recv_nm = 0;
+		for (auto& it: db->get_db())
+		{
+			for (auto& entry: it.second)
+			{
+				if(entry.navaid != nullptr &&
+					(static_cast<int>(entry.type) & RADNAV_DME_TYPES) &&
+					entry.navaid->max_recv > max_recv_nm)
+				{
+					max_recv_nm = entry.navaid->max_recv;
+				}
+			}
+		}
+		return max_recv_nm;
+	}
+
+	size_t get_best_dme_pairs(std::vector<navaid_t*>& dmes, geo::point ac_pos,
+		size_t k, std::vector<navaid_pair_t>* out)
+	{
+		out->clear();
+		if(k == 0)
+		{
+			return 0;
+		}
+
+		// Bearings from the DMEs to the aircraft. Most DMEs are never paired, so
+		// these are calculated on first use.
+		std::vector<double> brng_deg(dmes.size(), -1);
+		auto get_brng = [&dmes, &brng_deg, ac_pos](size_t idx) {
+			if(brng_deg[idx] < 0)
+			{
+				brng_deg[idx] = geo::rad_to_pos_deg(
+					dmes[idx]->data.pos.get_gc_bearing_rad(ac_pos));
+			}
+			return brng_deg[idx];
+		};
+
+		// out is kept as a min-heap while the pairs are being searched.
+		auto cmp = [](const navaid_pair_t& p1, const navaid_pair_t& p2) {
+			return p1.qual > p2.qual;
+		};
+
+		// The quality of a pair can't exceed (min(q1, q2) + 1) / 2. DMEs are sorted
+		// by quality, so once that bound drops below the worst pair found so far,
+		// the rest of the pairs don't need to be checked.
+		for (size_t i = 0; i + 1 < dmes.size(); i++)
+		{
+			if(out->size() == k && (dmes[i + 1]->qual + 1) / 2 <= out->front().qual)
+			{
+				break;
+			}
+
+			for (size_t j = i + 1; j < dmes.size(); j++)
+			{
+				if(out->size() == k && (dmes[j]->qual + 1) / 2 <= out->front().qual)
+				{
+					break;
+				}
+
+				// Same as navaid_pair_t::calc_qual but with cached bearings
+				double phi = abs(get_brng(i) - get_brng(j));
+				if (phi > 180)
+					phi = 360 - phi;
+
+				navaid_pair_t tmp = {dmes[i], dmes[j],
+					get_dme_dme_qual(phi, dmes[i]->qual, dmes[j]->qual)};
+				if(tmp.qual < 0)
+				{
+					continue;
+				}
+
+				if(out->size() < k)
+				{
+					out->push_back(tmp);
+					std::push_heap(out->begin(), out->end(), cmp);
+				}
+				else if(tmp.qual > out->front().qual)
+				{
+					std::pop_heap(out->begin(), out->end(), cmp);
+					out->back() = tmp;
+					std::push_heap(out->begin(), out->end(), cmp);
+				}
+			}
+		}
+
+		std::sort_heap(out->begin(), out->end(), cmp);
+		return out->size();
+	}
+
+	// NavaidSelector definitions:
+
+	NavaidSelector::NavaidSelector(std::shared_ptr<libnav::NavaidDB> db,
+		size_t n_vor_dme, size_t n_dme_dme)
+	{
+		navaid_db = db;
+		n_vor_dme_max = n_vor_dme;
+		n_dme_dme_max = n_dme_dme;
+		max_recv_nm = -1;
+	}
+
+	bool NavaidSelector::update(geo::point3d ac_pos)
+	{
+		vor_dme.clear();
+		dme_dme.clear();
+		dmes.clear();
+		dme_ptrs.clear();
+
+		if(!navaid_db->is_frozen())
+		{
+			return false;
+		}
+
+		if(max_recv_nm < 0)
+		{
+			max_recv_nm = get_max_dme_recv_nm(navaid_db);
+		}
+
+		// Stations further than max_recv_nm can't be received anyway
+		in_rng.clear();
+		navaid_db->get_in_radius(ac_pos.p, max_recv_nm,
+			libnav::NavaidType(RADNAV_DME_TYPES), &in_rng);
+		geo::nvec ac_nv = ac_pos.p.get_nvec();
+		for (size_t i = 0; i < in_rng.size(); i++)
+		{
+			navaid_t tmp = {in_rng[i].id, in_rng[i].data, -1};
+			tmp.calc_qual(ac_pos, ac_nv);
+			if(tmp.qual >= 0)
+			{
+				dmes.push_back(tmp);
+			}
+		}
+		std::stable_sort(dmes.begin(), dmes.end(),
+			[](const navaid_t& n1, const navaid_t& n2) {
+				return n1.qual > n2.qual;
+			});
+
+		for (size_t i = 0; i < dmes.size(); i++)
+		{
+			dme_ptrs.push_back(&dmes[i]);
+		}
+
+		update_vor_dme();
+		get_best_dme_pairs(dme_ptrs, ac_pos.p, n_dme_dme_max, &dme_dme);
+
+		return true;
+	}
+
+	const std::vector<navaid_t>& NavaidSelector::get_vor_dme()
+	{
+		return vor_dme;
+	}
+
+	const std::vector<navaid_pair_t>& NavaidSelector::get_dme_dme()
+	{
+		return dme_dme;
+	}
+
+	// Private member functions:
+
+	void NavaidSelector::update_vor_dme()
+	{
+		for (size_t i = 0; i < dmes.size() && vor_dme.size() < n_vor_dme_max; i++)
+		{
+			if(static_cast<int>(dmes[i].data.type) & RADNAV_VOR_DME_TYPES)
+			{
+				vor_dme.push_back(dmes[i]);
+			}
+		}
+	}
+
+	// NavaidTracker definitions:
+
+	NavaidTracker::NavaidTracker(std::shared_ptr<libnav::NavaidDB> db,
+		size_t n_vor_dme, size_t n_dme_dme, double margin)
+	{
+		navaid_db = db;
+		n_vor_dme_max = n_vor_dme;
+		n_dme_dme_max = n_dme_dme;
+		margin_nm = margin;
+		max_recv_nm = -1;
+		has_ref_pos = false;
+	}
+
+	bool NavaidTracker::update(geo::point3d ac_pos)
+	{
+		added.clear();
+		removed.clear();
+
+		if(!navaid_db->is_frozen())
+		{
+			return false;
+		}
+
+		double moved_nm = 0;
+		if(has_ref_pos)
+		{
+			moved_nm = ref_pos.get_gc_dist_nm(ac_pos.p);
+		}
+		bool is_reread = !has_ref_pos || moved_nm > margin_nm;
+		if(is_reread)
+		{
+			update_tracked(ac_pos);
+			recv.clear();
+			moved_nm = 0;
+		}
+
+		size_t n_prev_recv = recv.size();
+		geo::nvec ac_nv = ac_pos.p.get_nvec();
+		for (size_t i = 0; i < tracked.size(); i++)
+		{
+			// The station can't be closer than ref_dist_nm - moved_nm, so there is
+			// no need to calculate its quality if that is out of range.
+			if(ref_dist_nm[i] - moved_nm > tracked[i].data.navaid->max_recv)
+			{
+				tracked[i].qual = -1;
+			}
+			else
+			{
+				tracked[i].calc_qual(ac_pos, ac_nv);
+			}
+			bool curr_recv = tracked[i].qual >= 0;
+			if(curr_recv && (!is_recv[i] || is_reread))
+			{
+				recv.push_back(&tracked[i]);
+			}
+			if(curr_recv && !is_recv[i])
+			{
+				added.push_back(&tracked[i]);
+			}
+			else if(!curr_recv && is_recv[i])
+			{
+				removed.push_back(tracked[i]);
+			}
+			is_recv[i] = curr_recv;
+		}
+
+		auto cmp = [](const navaid_t* n1, const navaid_t* n2) {
+			return n1->qual > n2->qual;
+		};
+		if(is_reread)
+		{
+			std::stable_sort(recv.begin(), recv.end(), cmp);
+		}
+		else
+		{
+			// recv still has the order from the last update followed by the new
+			// stations. Qualities change slowly, so insertion sort is close to linear.
+			size_t n_kept = 0;
+			for (size_t i = 0; i < recv.size(); i++)
+			{
+				if(i >= n_prev_recv || recv[i]->qual >= 0)
+				{
+					recv[n_kept++] = recv[i];
+				}
+			}
+			recv.resize(n_kept);
+			for (size_t i = 1; i < recv.size(); i++)
+			{
+				navaid_t* curr = recv[i];
+				size_t j = i;
+				for (; j > 0 && cmp(curr, recv[j - 1]); j--)
+				{
+					recv[j] = recv[j - 1];
+				}
+				recv[j] = curr;
+			}
+		}
+
+		vor_dme.clear();
+		for (size_t i = 0; i < recv.size() && vor_dme.size() < n_vor_dme_max; i++)
+		{
+			if(static_cast<int>(recv[i]->data.type) & RADNAV_VOR_DME_TYPES)
+			{
+				vor_dme.push_back(recv[i]);
+			}
+		}
+		get_best_dme_pairs(recv, ac_pos.p, n_dme_dme_max, &dme_dme);
+
+		return true;
+	}
+
+	const std::vector<navaid_t*>& NavaidTracker::get_stations()
+	{
+		return recv;
+	}
+
+	const std::vector<navaid_t*>& NavaidTracker::get_added()
+	{
+		return added;
+	}
+
+	const std::vector<navaid_t>& NavaidTracker::get_removed()
+	{
+		return removed;
+	}
+
+	const std::vector<navaid_t*>& NavaidTracker::get_vor_dme()
+	{
+		return vor_dme;
+	}
+
+	const std::vector<navaid_pair_t>& NavaidTracker::get_dme_dme()
+	{
+		return dme_dme;
+	}
+
+	// Private member functions:
+
+	void NavaidTracker::update_tracked(geo::point3d ac_pos)
+	{
+		if(max_recv_nm < 0)
+		{
+			max_recv_nm = get_max_dme_recv_nm(navaid_db);
+		}
+
+		// Navaid entries are unique, so they are used to carry the reception state
+		// over to the new set of stations.
+		std::unordered_map<const libnav::navaid_entry_t*, size_t> old_idx;
+		for (size_t i = 0; i < tracked.size(); i++)
+		{
+			if(is_recv[i])
+			{
+				old_idx[tracked[i].data.navaid] = i;
+			}
+		}
+
+		std::vector<navaid_t> new_tracked;
+		std::vector<bool> new_is_recv;
+		geo::nvec ac_nv = ac_pos.p.get_nvec();
+		ref_dist_nm.clear();
+		in_rng.clear();
+		navaid_db->get_in_radius(ac_pos.p, max_recv_nm + margin_nm,
+			libnav::NavaidType(RADNAV_DME_TYPES), &in_rng);
+		for (size_t i = 0; i < in_rng.size(); i++)
+		{
+			libnav::waypoint_entry_t& data = in_rng[i].data;
+			if(data.navaid == nullptr)
+			{
+				continue;
+			}
+			// The approximate distance never exceeds the true distance, so it is a
+			// valid lower bound for the range check below and for ref_dist_nm.
+			double dist_nm = ac_nv.get_approx_dist_nm(data.get_nvec());
+			if(dist_nm > data.navaid->max_recv + margin_nm)
+			{
+				continue;
+			}
+
+			auto it = old_idx.find(data.navaid);
+			new_tracked.push_back({in_rng[i].id, data, -1});
+			new_is_recv.push_back(it != old_idx.end());
+			ref_dist_nm.push_back(dist_nm);
+			if(it != old_idx.end())
+			{
+				old_idx.erase(it);
+			}
+		}
+
+		// Receivable stations that aren't tracked anymore
+		for (size_t i = 0; i < tracked.size(); i++)
+		{
+			if(is_recv[i] && old_idx.find(tracked[i].data.navaid) != old_idx.end())
+			{
+				removed.push_back(tracked[i]);
+			}
+		}
+
+		std::swap(tracked, new_tracked);
+		std::swap(is_recv, new_is_recv);
+		ref_pos = ac_pos.p;
+		has_ref_pos = true;
+	}
+}; // namespace radnav_util
@@ -0,0 +1,461 @@
+/*
+	This project is licensed under
+	Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International Public License (CC BY-NC-SA 4.0).
+
+	A SUMMARY OF THIS LICENSE CAN BE FOUND HERE: https://creativecommons.org/licenses/by-nc-sa/4.0/
+
+	Author: discord/bruh4096#4512
+
+	This file contains definitions of member functions for RadnavFilter class.
+*/
+
+#include "libnav/radnav_filter.hpp"
+
+
+namespace radnav_util
+{
+	constexpr double SEC_PER_HR = 3600;
+	// Estimates aren't moved closer to the poles than this
+	constexpr double RADNAV_FILTER_MAX_LAT_RAD = M_PI / 2 - 1e-9;
+
+
+	/*
+		Returns the slant range from a station to the aircraft at p and its
+		derivatives by east and north displacement of the aircraft.
+	*/
+
+	inline double get_dme_pred(geo::point p, double ac_alt_ft, geo::point stn_pos,
+		double stn_elev_ft, double* h_e, double* h_n)
+	{
+		double sin_lat = sin(p.lat_rad), cos_lat = cos(p.lat_rad);
+		double sin_lon = sin(p.lon_rad), cos_lon = cos(p.lon_rad);
+		double r_ac = geo::EARTH_RADIUS_NM + ac_alt_ft * geo::FT_TO_NM;
+		double r_stn = geo::EARTH_RADIUS_NM + stn_elev_ft * geo::FT_TO_NM;
+		geo::nvec stn_nv = stn_pos.get_nvec();
+		double d_x = r_ac * cos_lat * cos_lon - r_stn * stn_nv.x;
+		double d_y = r_ac * cos_lat * sin_lon - r_stn * stn_nv.y;
+		double d_z = r_ac * sin_lat - r_stn * stn_nv.z;
+		double rho = sqrt(d_x * d_x + d_y * d_y + d_z * d_z);
+
+		*h_e = 0;
+		*h_n = 0;
+		if(rho > 0)
+		{
+			*h_e = (-d_x * sin_lon + d_y * cos_lon) / rho;
+			*h_n = (-d_x * sin_lat * cos_lon - d_y * sin_lat * sin_lon +
+				d_z * cos_lat) / rho;
+		}
+		return rho;
+	}
+
+	/*
+		Returns the radial of a station on which the aircraft at p is and its
+		derivatives by east and north displacement of the aircraft.
+	*/
+
+	inline double get_vor_pred(geo::point p, geo::point stn_pos, double* h_e,
+		double* h_n)
+	{
+		double d_nm = p.get_gc_dist_nm(stn_pos);
+		*h_e = 0;
+		*h_n = 0;
+		if(d_nm > 0)
+		{
+			// The radial is the bearing to the station plus 180 degrees
+			double brng_rad = p.get_gc_bearing_rad(stn_pos);
+			*h_e = -cos(brng_rad) / d_nm;
+			*h_n = sin(brng_rad) / d_nm;
+		}
+		return stn_pos.get_gc_bearing_rad(p);
+	}
+
+	// Returns the standard deviation of a VOR radial in radians
+	inline double get_vor_sigma_rad(geo::point p, double ac_alt_ft, geo::point stn_pos,
+		double stn_elev_ft)
+	{
+		double d_nm = p.get_gc_dist_nm(stn_pos);
+		double slant_nm = p.get_line_dist_nm(stn_pos, ac_alt_ft, stn_elev_ft);
+		return get_vor_fom(slant_nm) / (2 * d_nm);
+	}
+
+	// Wraps an angle to [-pi, pi]
+	inline double wrap_ang_rad(double ang_rad)
+	{
+		return ang_rad - 2 * M_PI * floor((ang_rad + M_PI) / (2 * M_PI));
+	}
+
+
+	RadnavFilter::RadnavFilter(double acc_sigma_kt_s, double gate_sigma)
+	{
+		double acc_sigma = acc_sigma_kt_s / SEC_PER_HR;
+		acc_var = acc_sigma * acc_sigma;
+		gate_sq = gate_sigma * gate_sigma;
+		has_guess = false;
+		guess = {0, 0};
+		is_filter_init = false;
+		n_rej_updates = 0;
+		pos = {0, 0};
+		vel_e = 0;
+		vel_n = 0;
+		for (size_t i = 0; i < 4; i++)
+		{
+			for (size_t j = 0; j < 4; j++)
+			{
+				cov[i][j] = 0;
+			}
+		}
+		n_used_last = 0;
+		n_rej_last = 0;
+	}
+
+	void RadnavFilter::reset()
+	{
+		has_guess = false;
+		is_filter_init = false;
+	}
+
+	void RadnavFilter::set_guess(geo::point guess_pos)
+	{
+		guess = guess_pos;
+		has_guess = true;
+	}
+
+	bool RadnavFilter::is_init()
+	{
+		return is_filter_init;
+	}
+
+	bool RadnavFilter::update(double dt_sec, const std::vector<radnav_meas_t>& meas,
+		double ac_alt_ft, radnav_est_t* out)
+	{
+		n_used_last = 0;
+		n_rej_last = 0;
+		if(!is_filter_init)
+		{
+			if(!start(meas, ac_alt_ft))
+			{
+				return false;
+			}
+			get_est(out);
+			return true;
+		}
+
+		predict(dt_sec);
+
+		for (size_t i = 0; i < meas.size(); i++)
+		{
+			const radnav_meas_t& m = meas[i];
+			if(m.stn == nullptr || m.stn->navaid == nullptr ||
+				get_navaid_qual(*m.stn, {pos, ac_alt_ft}) < 0)
+			{
+				continue;
+			}
+			double elev_ft = m.stn->navaid->elev_ft;
+
+			double h_e, h_n;
+			if(m.has_dme)
+			{
+				double rho = get_dme_pred(pos, ac_alt_ft, m.stn->pos, elev_ft,
+					&h_e, &h_n);
+				double sigma_nm = get_dme_fom(m.dist_nm) / 2;
+				if(apply_meas(m.dist_nm - rho, h_e, h_n, sigma_nm * sigma_nm))
+					n_used_last++;
+				else
+					n_rej_last++;
+			}
+			if(m.has_vor)
+			{
+				double radial_rad = get_vor_pred(pos, m.stn->pos, &h_e, &h_n);
+				double sigma_rad = get_vor_sigma_rad(pos, ac_alt_ft, m.stn->pos,
+					elev_ft);
+				if(apply_meas(wrap_ang_rad(m.radial_rad - radial_rad), h_e, h_n,
+					sigma_rad * sigma_rad))
+					n_used_last++;
+				else
+					n_rej_last++;
+			}
+		}
+
+		// Everything gets rejected once the estimate is far enough off
+		if(n_used_last == 0 && n_rej_last != 0)
+		{
+			n_rej_updates++;
+			if(n_rej_updates > RADNAV_FILTER_MAX_REJ_UPDATES)
+			{
+				is_filter_init = false;
+				return false;
+			}
+		}
+		else if(n_used_last != 0)
+		{
+			n_rej_updates = 0;
+		}
+
+		get_est(out);
+		return true;
+	}
+
+	// Private member functions:
+
+	void RadnavFilter::predict(double dt_sec)
+	{
+		if(dt_sec <= 0)
+		{
+			return;
+		}
+
+		move_pos(vel_e * dt_sec, vel_n * dt_sec);
+
+		// cov = F * cov * F^T + Q. Velocities are modelled as random walks.
+		for (size_t j = 0; j < 4; j++)
+		{
+			cov[0][j] += dt_sec * cov[2][j];
+			cov[1][j] += dt_sec * cov[3][j];
+		}
+		for (size_t i = 0; i < 4; i++)
+		{
+			cov[i][0] += dt_sec * cov[i][2];
+			cov[i][1] += dt_sec * cov[i][3];
+		}
+		double dt_sq = dt_sec * dt_sec;
+		for (size_t i = 0; i < 2; i++)
+		{
+			cov[i][i] += acc_var * dt_sq * dt_sec / 3;
+			cov[i][i + 2] += acc_var * dt_sq / 2;
+			cov[i + 2][i] += acc_var * dt_sq / 2;
+			cov[i + 2][i + 2] += acc_var * dt_sec;
+		}
+	}
+
+	bool RadnavFilter::apply_meas(double innov, double h_e, double h_n, double var)
+	{
+		double ph[4];
+		for (size_t i = 0; i < 4; i++)
+		{
+			ph[i] = cov[i][0] * h_e + cov[i][1] * h_n;
+		}
+		double s = h_e * ph[0] + h_n * ph[1] + var;
+		// Also rejects NaNs
+		if(!(s > 0 && innov * innov <= gate_sq * s))
+		{
+			return false;
+		}
+
+		double gain[4];
+		for (size_t i = 0; i < 4; i++)
+		{
+			gain[i] = ph[i] / s;
+		}
+		for (size_t i = 0; i < 4; i++)
+		{
+			for (size_t j = 0; j < 4; j++)
+			{
+				cov[i][j] -= gain[i] * ph[j];
+			}
+		}
+		for (size_t i = 0; i < 4; i++)
+		{
+			for (size_t j = i + 1; j < 4; j++)
+			{
+				double avg = (cov[i][j] + cov[j][i]) / 2;
+				cov[i][j] = avg;
+				cov[j][i] = avg;
+			}
+		}
+
+		move_pos(gain[0] * innov, gain[1] * innov);
+		vel_e += gain[2] * innov;
+		vel_n += gain[3] * innov;
+		return true;
+	}
+
+	void RadnavFilter::move_pos(double d_e_nm, double d_n_nm)
+	{
+		double lat_rad = pos.lat_rad + d_n_nm / geo::EARTH_RADIUS_NM;
+		lat_rad = std::min(std::max(lat_rad, -RADNAV_FILTER_MAX_LAT_RAD),
+			RADNAV_FILTER_MAX_LAT_RAD);
+		double lon_rad = pos.lon_rad + d_e_nm / (geo::EARTH_RADIUS_NM * cos(lat_rad));
+		pos = {lat_rad, wrap_ang_rad(lon_rad)};
+	}
+
+	bool RadnavFilter::start(const std::vector<radnav_meas_t>& meas, double ac_alt_ft)
+	{
+		double best_sigma = -1;
+		geo::point best_pos = {0, 0};
+
+		// VOR DME fixes
+		for (size_t i = 0; i < meas.size(); i++)
+		{
+			const radnav_meas_t& m = meas[i];
+			if(m.stn == nullptr || m.stn->navaid == nullptr || !m.has_dme || !m.has_vor)
+			{
+				continue;
+			}
+			double v_nm = (ac_alt_ft - m.stn->navaid->elev_ft) * geo::FT_TO_NM;
+			double d_sq = m.dist_nm * m.dist_nm - v_nm * v_nm;
+			if(d_sq <= 0)
+			{
+				continue;
+			}
+			geo::point cand = geo::get_pos_from_brng_dist(m.stn->pos, m.radial_rad,
+				sqrt(d_sq));
+			if(get_navaid_qual(*m.stn, {cand, ac_alt_ft}) < 0)
+			{
+				continue;
+			}
+			double sigma_nm = get_vor_dme_fom(m.dist_nm) / 2;
+			if(best_sigma < 0 || sigma_nm < best_sigma)
+			{
+				best_sigma = sigma_nm;
+				best_pos = cand;
+			}
+		}
+
+		// DME/DME fixes
+		for (size_t i = 0; i + 1 < meas.size(); i++)
+		{
+			const radnav_meas_t& m1 = meas[i];
+			if(m1.stn == nullptr || m1.stn->navaid == nullptr || !m1.has_dme)
+			{
+				continue;
+			}
+			for (size_t j = i + 1; j < meas.size(); j++)
+			{
+				const radnav_meas_t& m2 = meas[j];
+				if(m2.stn == nullptr || m2.stn->navaid == nullptr || !m2.has_dme)
+				{
+					continue;
+				}
+
+				// get_dme_dme_pos expects the westmost DME first
+				const radnav_meas_t* dme_u = &m1;
+				const radnav_meas_t* dme_s = &m2;
+				if(dme_u->stn->pos.lon_rad > dme_s->stn->pos.lon_rad)
+				{
+					std::swap(dme_u, dme_s);
+				}
+				geo::point cand[2];
+				int n_cand = geo::get_dme_dme_pos(dme_u->stn->pos, dme_s->stn->pos,
+					dme_u->dist_nm, dme_s->dist_nm, dme_u->stn->navaid->elev_ft,
+					dme_s->stn->navaid->elev_ft, ac_alt_ft, cand);
+				if(n_cand != 2)
+				{
+					continue;
+				}
+
+				// Pick one of the solutions
+				size_t k = 0;
+				if(has_guess)
+				{
+					if(guess.get_gc_dist_nm(cand[1]) < guess.get_gc_dist_nm(cand[0]))
+						k = 1;
+				}
+				else
+				{
+					size_t n_other = 0;
+					double cost[2];
+					for (size_t l = 0; l < 2; l++)
+					{
+						cost[l] = get_cost(meas, cand[l], ac_alt_ft, i, j, &n_other);
+					}
+					if(cost[1] < cost[0])
+						k = 1;
+					// Give up unless exactly one of the solutions fits
+					double max_cost = gate_sq * double(n_other);
+					if(n_other == 0 || !(cost[k] <= max_cost) || cost[1 - k] <= max_cost)
+					{
+						continue;
+					}
+				}
+
+				double b1_rad = cand[k].get_gc_bearing_rad(m1.stn->pos);
+				double b2_rad = cand[k].get_gc_bearing_rad(m2.stn->pos);
+				double phi_rad = abs(wrap_ang_rad(b1_rad - b2_rad));
+				double q1 = get_navaid_qual(*m1.stn, {cand[k], ac_alt_ft});
+				double q2 = get_navaid_qual(*m2.stn, {cand[k], ac_alt_ft});
+				if(q1 < 0 || q2 < 0 ||
+					get_dme_dme_qual(phi_rad * geo::RAD_TO_DEG, q1, q2) < 0)
+				{
+					continue;
+				}
+				double sigma_nm = get_dme_dme_fom(m1.dist_nm, m2.dist_nm, phi_rad) / 2;
+				if(best_sigma < 0 || sigma_nm < best_sigma)
+				{
+					best_sigma = sigma_nm;
+					best_pos = cand[k];
+				}
+			}
+		}
+
+		if(!(best_sigma > 0))
+		{
+			return false;
+		}
+
+		pos = best_pos;
+		vel_e = 0;
+		vel_n = 0;
+		double vel_sigma = RADNAV_FILTER_INIT_VEL_SIGMA_KT / SEC_PER_HR;
+		for (size_t i = 0; i < 4; i++)
+		{
+			for (size_t j = 0; j < 4; j++)
+			{
+				cov[i][j] = 0;
+			}
+		}
+		cov[0][0] = best_sigma * best_sigma;
+		cov[1][1] = best_sigma * best_sigma;
+		cov[2][2] = vel_sigma * vel_sigma;
+		cov[3][3] = vel_sigma * vel_sigma;
+		is_filter_init = true;
+		n_rej_updates = 0;
+		return true;
+	}
+
+	double RadnavFilter::get_cost(const std::vector<radnav_meas_t>& meas, geo::point p,
+		double ac_alt_ft, size_t skip_1, size_t skip_2, size_t* n_meas)
+	{
+		double cost = 0;
+		*n_meas = 0;
+		for (size_t i = 0; i < meas.size(); i++)
+		{
+			const radnav_meas_t& m = meas[i];
+			if(m.stn == nullptr || m.stn->navaid == nullptr)
+			{
+				continue;
+			}
+			double elev_ft = m.stn->navaid->elev_ft;
+			double h_e, h_n;
+			if(m.has_dme && i != skip_1 && i != skip_2)
+			{
+				double res = m.dist_nm - get_dme_pred(p, ac_alt_ft, m.stn->pos, elev_ft,
+					&h_e, &h_n);
+				double sigma_nm = get_dme_fom(m.dist_nm) / 2;
+				cost += (res * res) / (sigma_nm * sigma_nm);
+				(*n_meas)++;
+			}
+			if(m.has_vor)
+			{
+				double res = wrap_ang_rad(m.radial_rad - get_vor_pred(p, m.stn->pos,
+					&h_e, &h_n));
+				double sigma_rad = get_vor_sigma_rad(p, ac_alt_ft, m.stn->pos, elev_ft);
+				cost += (res * res) / (sigma_rad * sigma_rad);
+				(*n_meas)++;
+			}
+		}
+		return cost;
+	}
+
+	void RadnavFilter::get_est(radnav_est_t* out)
+	{
+		out->pos = pos;
+		out->vel_e_kt = vel_e * SEC_PER_HR;
+		out->vel_n_kt = vel_n * SEC_PER_HR;
+		out->cov_ee = cov[0][0];
+		out->cov_en = cov[0][1];
+		out->cov_nn = cov[1][1];
+		out->anp_nm = 2 * sqrt(cov[0][0] + cov[1][1]);
+		out->n_used = n_used_last;
+		out->n_rej = n_rej_last;
+	}
+}; // namespace radnav_util
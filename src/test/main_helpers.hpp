@@ -1,10 +1,17 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
+#include <chrono>
+#include <fstream>
 #include <libnav/awy_db.hpp>
 #include <libnav/hold_db.hpp>
 #include <libnav/cifp_parser.hpp>
+#include <libnav/navaid_selector.hpp>
+#include <libnav/fom_batch.hpp>
+#include <libnav/dme_solver.hpp>
 #include <libnav/geo_utils.hpp>
+#include <libnav/geo_batch.hpp>
 
 #define UNUSED(x) (void)(x)
 
@@ -30,6 +37,8 @@ namespace dbg
         std::unordered_map<std::string, std::string> env_vars;
 
         std::string cifp_dir_path;
+        std::string fix_data_path;
+        std::string navaid_data_path;
 
 
         Avionics(std::string apt_dat, std::string custom_apt, std::string custom_rnw,
@@ -42,6 +51,8 @@ namespace dbg
             env_vars["ac_lon"] = strutils::double_to_str(def_lon, 8);
 
             cifp_dir_path = cifp_path;
+            fix_data_path = fix_data;
+            navaid_data_path = navaid_data;
 
             ac_lat = def_lat;
             ac_lon = def_lon;
@@ -248,6 +259,498 @@ namespace dbg
         }
     }
 
+    inline void nearest(Avionics* av, std::vector<std::string>& in)
+    {
+        if(in.size() != 1 || !strutils::is_numeric(in[0]))
+        {
+            std::cout << "Command expects 1 argument: <number of fixes>\n";
+            return;
+        }
+
+        geo::point ac_pos = {av->ac_lat * geo::DEG_TO_RAD, av->ac_lon * geo::DEG_TO_RAD};
+        size_t k = size_t(std::max(std::stoi(in[0]), 0));
+        std::vector<libnav::waypoint_t> found_wpts;
+
+        av->navaid_db_ptr->get_k_nearest(ac_pos, k, libnav::NavaidType::NONE, 
+            &found_wpts);
+
+        for(size_t i = 0; i < found_wpts.size(); i++)
+        {
+            std::string type_str = libnav::navaid_to_str(found_wpts[i].data.type);
+            std::cout << found_wpts[i].id << " " << type_str << " " << 
+                strutils::double_to_str(found_wpts[i].data.pos.get_gc_dist_nm(ac_pos), 2) 
+                << "\n";
+        }
+    }
+
+    inline void radnav(Avionics* av, std::vector<std::string>& in)
+    {
+        if(in.size() != 2 || !strutils::is_numeric(in[0]) || 
+            !strutils::is_numeric(in[1]))
+        {
+            std::cout << "Command expects 2 arguments: <altitude(feet)> <number of candidates>\n";
+            return;
+        }
+
+        geo::point3d ac_pos = {{av->ac_lat * geo::DEG_TO_RAD, 
+            av->ac_lon * geo::DEG_TO_RAD}, double(std::stoi(in[0]))};
+        size_t k = size_t(std::max(std::stoi(in[1]), 0));
+        radnav_util::NavaidSelector sel(av->navaid_db_ptr, k, k);
+        sel.update(ac_pos);
+
+        std::cout << "VOR/DME:\n";
+        for(auto& it: sel.get_vor_dme())
+        {
+            std::cout << it.id << " " << strutils::double_to_str(it.qual, 3) << "\n";
+        }
+        std::cout << "DME/DME:\n";
+        for(auto& it: sel.get_dme_dme())
+        {
+            std::cout << it.n1->id << " " << it.n2->id << " " << 
+                strutils::double_to_str(it.qual, 3) << "\n";
+        }
+    }
+
+    inline void fom_bench(Avionics* av, std::vector<std::string>& in)
+    {
+        UNUSED(av);
+
+        if(in.size() != 2 || !strutils::is_numeric(in[0]) || 
+            !strutils::is_numeric(in[1]))
+        {
+            std::cout << "Command expects 2 arguments: <number of stations> <number of frames>\n";
+            return;
+        }
+
+        size_t n_stations = size_t(std::max(std::stoi(in[0]), 1));
+        size_t n_frames = size_t(std::max(std::stoi(in[1]), 1));
+
+        std::vector<double> dist1(n_stations), dist2(n_stations), phi(n_stations);
+        std::vector<double> out(n_stations), out_batch(n_stations);
+        for(size_t i = 0; i < n_stations; i++)
+        {
+            dist1[i] = double(i % 300);
+            dist2[i] = double((i * 7) % 300);
+            phi[i] = double(i % 180) * geo::DEG_TO_RAD;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_frames; i++)
+        {
+            for(size_t j = 0; j < n_stations; j++)
+            {
+                out[j] = radnav_util::get_vor_dme_fom(dist1[j]);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_frames; i++)
+        {
+            radnav_util::get_vor_dme_fom_batch(dist1.data(), n_stations, out_batch.data());
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        bool is_equal = out == out_batch;
+        for(size_t i = 0; i < n_frames; i++)
+        {
+            for(size_t j = 0; j < n_stations; j++)
+            {
+                out[j] = radnav_util::get_dme_dme_fom(dist1[j], dist2[j], phi[j]);
+            }
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_frames; i++)
+        {
+            radnav_util::get_dme_dme_fom_batch(dist1.data(), dist2.data(), phi.data(), 
+                n_stations, out_batch.data());
+        }
+        auto end = std::chrono::steady_clock::now();
+        is_equal = is_equal && out == out_batch;
+
+        double n_fr = double(n_frames);
+        std::cout << "VOR/DME scalar: " << 
+            std::chrono::duration<double, std::milli>(t1 - start).count() / n_fr << 
+            " ms/frame, batch: " << 
+            std::chrono::duration<double, std::milli>(t2 - t1).count() / n_fr << 
+            " ms/frame\n";
+        std::cout << "DME/DME scalar: " << 
+            std::chrono::duration<double, std::milli>(t3 - t2).count() / n_fr << 
+            " ms/frame, batch: " << 
+            std::chrono::duration<double, std::milli>(end - t3).count() / n_fr << 
+            " ms/frame\n";
+        std::cout << "Results match: " << is_equal << "\n";
+    }
+
+    inline void geo_bench(Avionics* av, std::vector<std::string>& in)
+    {
+        if(in.size() != 2 || !strutils::is_numeric(in[0]) || 
+            !strutils::is_numeric(in[1]))
+        {
+            std::cout << "Command expects 2 arguments: <number of points> <number of passes>\n";
+            return;
+        }
+
+        size_t n_pts = size_t(std::max(std::stoi(in[0]), 1));
+        size_t n_passes = size_t(std::max(std::stoi(in[1]), 1));
+
+        // Points are spread over a 20x20 degree area around the aircraft. None of them
+        // is at the aircraft, where the bearing isn't defined.
+        geo::point ac_pos = {av->ac_lat * geo::DEG_TO_RAD, av->ac_lon * geo::DEG_TO_RAD};
+        std::vector<geo::point> pts(n_pts);
+        geo::point_soa pts_soa;
+        for(size_t i = 0; i < n_pts; i++)
+        {
+            double d_lat = double((i * 7919) % 2000) / 100 - 9.995;
+            double d_lon = double((i * 104729) % 2000) / 100 - 9.995;
+            pts[i] = {ac_pos.lat_rad + d_lat * geo::DEG_TO_RAD, 
+                ac_pos.lon_rad + d_lon * geo::DEG_TO_RAD};
+            pts_soa.push_back(pts[i]);
+        }
+
+        std::vector<double> dist(n_pts), brng(n_pts);
+        std::vector<double> dist_batch, brng_batch;
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_passes; i++)
+        {
+            for(size_t j = 0; j < n_pts; j++)
+            {
+                dist[j] = ac_pos.get_gc_dist_nm(pts[j]);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_passes; i++)
+        {
+            geo::get_gc_dist_nm_batch(ac_pos, pts_soa, &dist_batch);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_passes; i++)
+        {
+            for(size_t j = 0; j < n_pts; j++)
+            {
+                brng[j] = ac_pos.get_gc_bearing_rad(pts[j]);
+            }
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_passes; i++)
+        {
+            geo::get_gc_bearing_rad_batch(ac_pos, pts_soa, &brng_batch);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double max_dist_diff = 0, max_brng_diff = 0;
+        for(size_t i = 0; i < n_pts; i++)
+        {
+            max_dist_diff = std::max(max_dist_diff, abs(dist[i] - dist_batch[i]));
+            // Bearings of pi and -pi are the same
+            max_brng_diff = std::max(max_brng_diff, 
+                abs(remainder(brng[i] - brng_batch[i], 2 * M_PI)));
+        }
+
+        double n_calls = double(n_passes * n_pts);
+        std::cout << "Distance scalar: " << 
+            std::chrono::duration<double, std::nano>(t1 - start).count() / n_calls << 
+            " ns/point, batch: " << 
+            std::chrono::duration<double, std::nano>(t2 - t1).count() / n_calls << 
+            " ns/point\n";
+        std::cout << "Bearing scalar: " << 
+            std::chrono::duration<double, std::nano>(t3 - t2).count() / n_calls << 
+            " ns/point, batch: " << 
+            std::chrono::duration<double, std::nano>(end - t3).count() / n_calls << 
+            " ns/point\n";
+        std::cout << "Max difference: " << max_dist_diff << " nm, " << 
+            max_brng_diff << " rad\n";
+    }
+
+    inline void dme_bench(Avionics* av, std::vector<std::string>& in)
+    {
+        if(in.size() != 2 || !strutils::is_numeric(in[0]) || 
+            !strutils::is_numeric(in[1]))
+        {
+            std::cout << "Command expects 2 arguments: <number of DMEs> <number of fixes>\n";
+            return;
+        }
+
+        size_t n_dmes = size_t(std::max(std::stoi(in[0]), 2));
+        size_t n_fixes = size_t(std::max(std::stoi(in[1]), 1));
+
+        geo::point ac_start = {av->ac_lat * geo::DEG_TO_RAD, av->ac_lon * geo::DEG_TO_RAD};
+        double ac_alt_ft = 20000;
+        std::vector<radnav_util::dme_meas_t> meas(n_dmes);
+        for(size_t i = 0; i < n_dmes; i++)
+        {
+            double brng_rad = 2 * M_PI * double(i) / double(n_dmes);
+            meas[i].pos = geo::get_pos_from_brng_dist(ac_start, brng_rad, 
+                double(30 + (i % 5) * 10));
+            meas[i].elev_ft = double((i % 4) * 500);
+        }
+
+        // The aircraft flies east at 480 kts. Fixes are made at 20 Hz, each one 
+        // starting from the previous one.
+        radnav_util::DmeSolver solver;
+        solver.set_guess(ac_start);
+        radnav_util::dme_fix_t fix;
+        size_t n_found = 0, n_iter = 0;
+        double max_err_nm = 0;
+        std::chrono::duration<double, std::micro> t_solve(0);
+        for(size_t i = 0; i < n_fixes; i++)
+        {
+            geo::point ac_pos = geo::get_pos_from_brng_dist(ac_start, M_PI / 2, 
+                double(i) * 480.0 / 3600 / 20);
+            for(size_t j = 0; j < n_dmes; j++)
+            {
+                meas[j].dist_nm = ac_pos.get_line_dist_nm(meas[j].pos, ac_alt_ft, 
+                    meas[j].elev_ft);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            bool is_found = solver.solve(meas, ac_alt_ft, &fix);
+            t_solve += std::chrono::steady_clock::now() - start;
+
+            if(is_found)
+            {
+                n_found++;
+                n_iter += fix.n_iter;
+                max_err_nm = std::max(max_err_nm, fix.pos.get_gc_dist_nm(ac_pos));
+            }
+        }
+
+        std::cout << "Fixes found: " << n_found << "/" << n_fixes << "\n";
+        std::cout << "Iterations per fix: " << 
+            double(n_iter) / double(std::max(n_found, size_t(1))) << "\n";
+        std::cout << "Time per fix: " << t_solve.count() / double(n_fixes) << " us\n";
+        std::cout << "Max error: " << max_err_nm << " nm\n";
+    }
+
+    inline void navaid_merge_check(Avionics* av, std::vector<std::string>& in)
+    {
+        // Merges colocated navaids of earth_nav.dat by comparing every navaid with 
+        // all navaids that have the same id, as it was done before the merge index,
+        // and compares the result with the data base.
+        UNUSED(in);
+
+        struct ref_navaid_t
+        {
+            libnav::waypoint_entry_t wpt;
+            libnav::navaid_entry_t navaid;
+            std::string desc;
+        };
+
+        std::ifstream file(av->navaid_data_path);
+        if(!file.is_open())
+        {
+            std::cout << "Unable to open " << av->navaid_data_path << "\n";
+            return;
+        }
+
+        std::unordered_map<std::string, std::vector<ref_navaid_t>> ref;
+        std::string line;
+        int line_num = 0;
+        while(std::getline(file, line))
+        {
+            line_num++;
+            if(line_num <= libnav::N_EARTH_LINES_IGNORE)
+            {
+                continue;
+            }
+
+            libnav::navaid_line_t navaid_line(line);
+            if(navaid_line.data.is_last)
+            {
+                break;
+            }
+            if(!navaid_line.data.is_parsed)
+            {
+                continue;
+            }
+
+            libnav::waypoint_entry_t& wpt = navaid_line.wpt.data;
+            libnav::navaid_entry_t& navaid = navaid_line.navaid;
+            std::vector<ref_navaid_t>& entries = ref[navaid_line.wpt.id];
+            bool is_merged = false;
+            for(size_t i = 0; i < entries.size() && !is_merged; i++)
+            {
+                ref_navaid_t& tmp = entries[i];
+                bool is_equal = !memcmp(&tmp.wpt.pos, &wpt.pos, sizeof(geo::point)) && 
+                    tmp.wpt.type == wpt.type && 
+                    !memcmp(&tmp.navaid, &navaid, sizeof(libnav::navaid_entry_t));
+                double ang_dev = abs(wpt.pos.lat_rad - tmp.wpt.pos.lat_rad) + 
+                    abs(wpt.pos.lon_rad - tmp.wpt.pos.lon_rad);
+                libnav::NavaidType type_sum = libnav::make_composite(wpt.type, 
+                    tmp.wpt.type);
+                if(is_equal)
+                {
+                    is_merged = true;
+                }
+                else if(ang_dev < libnav::MAX_ANG_DEV_MERGE && 
+                    type_sum != libnav::NavaidType::NONE && navaid.freq == tmp.navaid.freq)
+                {
+                    tmp.wpt.type = type_sum;
+                    is_merged = true;
+                }
+                if(is_merged)
+                {
+                    tmp.desc = std::string(navaid_line.desc.ptr, navaid_line.desc.len);
+                }
+            }
+            if(!is_merged)
+            {
+                entries.push_back({wpt, navaid, 
+                    std::string(navaid_line.desc.ptr, navaid_line.desc.len)});
+            }
+        }
+
+        size_t n_ref = 0, n_ids = 0, n_diff = 0;
+        for(auto& it: ref)
+        {
+            n_ref += it.second.size();
+        }
+        for(auto& it: av->navaid_db_ptr->get_db())
+        {
+            std::vector<libnav::waypoint_entry_t> navaids;
+            for(auto& entry: it.second)
+            {
+                if(entry.navaid != nullptr)
+                {
+                    navaids.push_back(entry);
+                }
+            }
+            if(navaids.empty())
+            {
+                continue;
+            }
+            n_ids++;
+
+            auto ref_it = ref.find(it.first);
+            bool is_same = ref_it != ref.end() && ref_it->second.size() == navaids.size();
+            for(size_t i = 0; is_same && i < navaids.size(); i++)
+            {
+                ref_navaid_t& tmp = ref_it->second[i];
+                libnav::waypoint_t wpt = {it.first, navaids[i]};
+                std::string desc = navaids[i].desc_offset ? 
+                    av->navaid_db_ptr->get_fix_desc(wpt) : "";
+                is_same = navaids[i].type == tmp.wpt.type && 
+                    navaids[i].arinc_type == tmp.wpt.arinc_type && 
+                    !memcmp(&navaids[i].pos, &tmp.wpt.pos, sizeof(geo::point)) && 
+                    navaids[i].area_code == tmp.wpt.area_code && 
+                    navaids[i].country_code == tmp.wpt.country_code && 
+                    navaids[i].navaid->cmp(tmp.navaid) && desc == tmp.desc;
+            }
+            if(!is_same)
+            {
+                n_diff++;
+                std::cout << "Navaids differ: " << it.first << "\n";
+            }
+        }
+        if(n_ids != ref.size())
+        {
+            n_diff++;
+            std::cout << "Number of navaid ids differs: " << n_ids << " " << 
+                ref.size() << "\n";
+        }
+
+        std::cout << "Navaids in reference: " << n_ref << ", ids with differences: " << 
+            n_diff << "\n";
+    }
+
+    inline void lookup_bench(Avionics* av, std::vector<std::string>& in)
+    {
+        if(in.size() != 2 || !strutils::is_numeric(in[0]) || 
+            !strutils::is_numeric(in[1]))
+        {
+            std::cout << "Command expects 2 arguments: <number of threads> <number of passes>\n";
+            return;
+        }
+
+        size_t n_thr = size_t(std::max(std::stoi(in[0]), 1));
+        size_t n_passes = size_t(std::max(std::stoi(in[1]), 1));
+
+        std::vector<std::string> ids;
+        for(auto& it: av->navaid_db_ptr->get_db())
+        {
+            ids.push_back(it.first);
+        }
+
+        auto reader = [](Avionics* av, std::vector<std::string>* ids, size_t n_passes, 
+            size_t* n_found) 
+        {
+            std::vector<libnav::waypoint_entry_t> found_wpts;
+            for(size_t i = 0; i < n_passes; i++)
+            {
+                for(size_t j = 0; j < ids->size(); j++)
+                {
+                    found_wpts.clear();
+                    *n_found += av->navaid_db_ptr->get_wpt_data(ids->at(j), &found_wpts, 
+                        "", "", libnav::NavaidType::NONE);
+                }
+            }
+        };
+
+        std::vector<size_t> n_found(n_thr, 0);
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n_thr; i++)
+        {
+            threads.push_back(std::thread(reader, av, &ids, n_passes, &n_found[i]));
+        }
+        for(size_t i = 0; i < n_thr; i++)
+        {
+            threads[i].join();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double dur_sec = std::chrono::duration<double>(end - start).count();
+        double n_lookups = double(n_thr * n_passes * ids.size());
+        std::cout << "Frozen: " << av->navaid_db_ptr->is_frozen() << "\n";
+        std::cout << n_lookups << " lookups in " << dur_sec << " s, " << 
+            n_lookups / dur_sec << " lookups/s\n";
+    }
+
+    inline void load_bench(Avionics* av, std::vector<std::string>& in)
+    {
+        if(in.size() != 2 || !strutils::is_numeric(in[0]) || 
+            !strutils::is_numeric(in[1]))
+        {
+            std::cout << "Command expects 2 arguments: <number of threads> <number of passes>\n";
+            return;
+        }
+
+        size_t n_thr = size_t(std::max(std::stoi(in[0]), 1));
+        size_t n_passes = size_t(std::max(std::stoi(in[1]), 1));
+
+        // Only the fix data base is loaded, so the navaid loader doesn't 
+        // take any of the cores.
+        auto load = [](Avionics* av, size_t n_load_thr, size_t n_passes, 
+            size_t* n_entries) -> double
+        {
+            double dur_sec = 0;
+            for(size_t i = 0; i < n_passes; i++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                libnav::NavaidDB db(av->fix_data_path, "", n_load_thr);
+                libnav::DbErr err = db.get_wpt_err();
+                auto end = std::chrono::steady_clock::now();
+                dur_sec += std::chrono::duration<double>(end - start).count();
+                db.get_navaid_err();
+
+                *n_entries = 0;
+                if(err != libnav::DbErr::SUCCESS && err != libnav::DbErr::PARTIAL_LOAD)
+                    continue;
+                for(auto& it: db.get_db())
+                {
+                    *n_entries += it.second.size();
+                }
+            }
+            return dur_sec / double(n_passes);
+        };
+
+        size_t n_entries_1 = 0;
+        size_t n_entries_n = 0;
+        double dur_1 = load(av, 1, n_passes, &n_entries_1);
+        double dur_n = load(av, n_thr, n_passes, &n_entries_n);
+
+        std::cout << "Fixes loaded: " << n_entries_1 << " " << n_entries_n << "\n";
+        std::cout << "1 thread: " << dur_1 * 1000 << " ms, " << n_thr << " threads: " << 
+            dur_n * 1000 << " ms, speedup: " << dur_1 / dur_n << "\n";
+    }
+
     inline void get_path(Avionics* av, std::vector<std::string>& in)
     {
         if(in.size() != 3)
@@ -659,6 +1162,14 @@ namespace dbg
         {"p", print},
         {"name", name}, 
         {"poinfo", display_poi_info}, 
+        {"nearest", nearest},
+        {"radnav", radnav},
+        {"lookup_bench", lookup_bench},
+        {"load_bench", load_bench},
+        {"fom_bench", fom_bench},
+        {"geo_bench", geo_bench},
+        {"dme_bench", dme_bench},
+        {"navaid_merge_check", navaid_merge_check},
         {"get_path", get_path},
         {"get_aa_path", get_aa_path},
         {"holdinfo", hold_info},